@@ -11,7 +11,8 @@ macro(if_defined_set var value)
 endmacro()
 
 
-# Add a boost test
+# Add a boost test, the test case name is matched as a prefix so that all
+# instances of a parameterized test case are run
 macro(addTest testCase)
-  add_test(${testCase} ${PROJECT_NAME}_test --run_test=${testCase})
+  add_test(${testCase} ${PROJECT_NAME}_test --run_test=${testCase}*)
 endmacro()
\ No newline at end of file
@@ -9,8 +9,18 @@ set(${PROJECT_NAME}_srcs ${srcs_dir}/tnp.cpp
                         ${srcs_dir}/npnumber.cpp
 			${srcs_dir}/multiplication.cpp
 			${srcs_dir}/composition.cpp
+			${srcs_dir}/elementary.cpp
+			${srcs_dir}/functions.cpp
+			${srcs_dir}/power.cpp
 			${srcs_dir}/polynomial.cpp
 			${srcs_dir}/ops.cpp
+			${srcs_dir}/pool.cpp
+			${srcs_dir}/context.cpp
+			${srcs_dir}/layout.cpp
+			${srcs_dir}/tape.cpp
+			${srcs_dir}/tapeoptimizer.cpp
+			${srcs_dir}/paralleltape.cpp
+			${srcs_dir}/tapecompiler.cpp
   )
 
 #Project tests
@@ -21,7 +31,27 @@ set(${PROJECT_NAME}_headers ${hdrs_dir}/tnp.h
 			    ${hdrs_dir}/tnp.hpp
                             ${hdrs_dir}/tnp/ops.h
 			    ${hdrs_dir}/tnp/npnumber.hpp
+			    ${hdrs_dir}/tnp/fieldvector.hpp
+			    ${hdrs_dir}/tnp/pool.hpp
+			    ${hdrs_dir}/tnp/context.h
+			    ${hdrs_dir}/tnp/context.hpp
+			    ${hdrs_dir}/tnp/expression.hpp
+			    ${hdrs_dir}/tnp/fixednpnumber.hpp
+			    ${hdrs_dir}/tnp/genericnpnumber.hpp
+			    ${hdrs_dir}/tnp/npnumberview.hpp
+			    ${hdrs_dir}/tnp/alignednpnumber.hpp
+			    ${hdrs_dir}/tnp/transposednpnumber.hpp
+			    ${hdrs_dir}/tnp/tape.hpp
+			    ${hdrs_dir}/tnp/tapeoptimizer.hpp
+			    ${hdrs_dir}/tnp/paralleltape.hpp
+			    ${hdrs_dir}/tnp/tapecompiler.hpp
 			    ${hdrs_dir}/tnp/polynomial.hpp
+			    ${hdrs_dir}/tnp/ordertable.hpp
 			    ${hdrs_dir}/tnp/ops/multiplication.hpp
 			    ${hdrs_dir}/tnp/ops/composition.hpp
+			    ${hdrs_dir}/tnp/ops/elementary.hpp
+			    ${hdrs_dir}/tnp/ops/functions.hpp
+			    ${hdrs_dir}/tnp/ops/power.hpp
+			    ${hdrs_dir}/tnp/ops/fixed.hpp
+			    ${hdrs_dir}/tnp/ops/layout.hpp
 			    )
\ No newline at end of file
@@ -23,16 +23,31 @@
 extern "C" {
 #endif
 
+#include <tnp/context.h>
+
+/*
+ * Every function creating or computing a number has a *_ctx variant taking the tnp_context
+ * to evaluate in, new handles are drawn from its allocator. The plain functions use the
+ * default context of the calling thread. A handle may be deleted through any context.
+ */
 struct tnp_number;
 
 struct tnp_number* tnp_number_create(int params, int order);
 
+struct tnp_number* tnp_number_create_ctx(struct tnp_context* ctx, int params, int order);
+
 struct tnp_number* tnp_number_create_variable(double val, int nr, int params, int order);
 
+struct tnp_number* tnp_number_create_variable_ctx(struct tnp_context* ctx, double val, int nr, int params, int order);
+
 struct tnp_number* tnp_number_create_constant(double val, int params, int order);
 
+struct tnp_number* tnp_number_create_constant_ctx(struct tnp_context* ctx, double val, int params, int order);
+
 void tnp_number_delete(struct tnp_number* nr);
 
+void tnp_number_delete_ctx(struct tnp_context* ctx, struct tnp_number* nr);
+
 int tnp_number_params(struct tnp_number* nr);
 
 int tnp_number_order(struct tnp_number* nr);
@@ -47,15 +62,27 @@ double tnp_number_mixed_derivative(struct tnp_number* nr, int order, int param);
 
 struct tnp_number* tnp_number_add(struct tnp_number* a, struct tnp_number* b);
 
+struct tnp_number* tnp_number_add_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number* b);
+
 struct tnp_number* tnp_number_dadd(struct tnp_number* a, double b);
 
+struct tnp_number* tnp_number_dadd_ctx(struct tnp_context* ctx, struct tnp_number* a, double b);
+
 struct tnp_number* tnp_number_mult(struct tnp_number* a, struct tnp_number* b);
 
+struct tnp_number* tnp_number_mult_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number* b);
+
 struct tnp_number* tnp_number_dmult(struct tnp_number* a, double b);
 
+struct tnp_number* tnp_number_dmult_ctx(struct tnp_context* ctx, struct tnp_number* a, double b);
+
 struct tnp_number* tnp_number_sub(struct tnp_number* a, struct tnp_number* b);
 
+struct tnp_number* tnp_number_sub_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number* b);
+
 struct tnp_number* tnp_number_dsub(struct tnp_number* a, double b);
+
+struct tnp_number* tnp_number_dsub_ctx(struct tnp_context* ctx, struct tnp_number* a, double b);
 /*
 struct tnp_number* tnp_number_div(struct tnp_number* a, struct tnp_number* b);
 
@@ -63,6 +90,147 @@ struct tnp_number* tnp_number_ddiv(struct tnp_number* a, double b);
 */
 struct tnp_number* tnp_number_pow(struct tnp_number* a, int power);
 
+struct tnp_number* tnp_number_pow_ctx(struct tnp_context* ctx, struct tnp_number* a, int power);
+
+struct tnp_number* tnp_number_powr(struct tnp_number* a, double power);
+
+struct tnp_number* tnp_number_powr_ctx(struct tnp_context* ctx, struct tnp_number* a, double power);
+
+struct tnp_number* tnp_number_npow(struct tnp_number* a, struct tnp_number* b);
+
+struct tnp_number* tnp_number_npow_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number* b);
+
+struct tnp_number* tnp_number_atan2(struct tnp_number* y, struct tnp_number* x);
+
+struct tnp_number* tnp_number_atan2_ctx(struct tnp_context* ctx, struct tnp_number* y, struct tnp_number* x);
+
+struct tnp_number* tnp_number_hypot(struct tnp_number* x, struct tnp_number* y);
+
+struct tnp_number* tnp_number_hypot_ctx(struct tnp_context* ctx, struct tnp_number* x, struct tnp_number* y);
+
+struct tnp_number* tnp_number_sqrt(struct tnp_number* a);
+
+struct tnp_number* tnp_number_sqrt_ctx(struct tnp_context* ctx, struct tnp_number* a);
+
+struct tnp_number* tnp_number_cbrt(struct tnp_number* a);
+
+struct tnp_number* tnp_number_cbrt_ctx(struct tnp_context* ctx, struct tnp_number* a);
+
+/*
+ * applies a function registered by tnp_function_register (see tnp/ops.h), NULL for an unknown id
+ */
+struct tnp_number* tnp_number_apply(struct tnp_number* a, int function);
+
+struct tnp_number* tnp_number_apply_ctx(struct tnp_context* ctx, struct tnp_number* a, int function);
+
+/*
+ * applies m registered functions to a, the results are stored in results,
+ * all of them NULL if one of the ids is unknown
+ */
+void tnp_number_apply_many(struct tnp_number* a, int* functions, int m, struct tnp_number** results);
+
+void tnp_number_apply_many_ctx(struct tnp_context* ctx, struct tnp_number* a, int* functions, int m, struct tnp_number** results);
+
+struct tnp_number* tnp_number_exp(struct tnp_number* a);
+
+struct tnp_number* tnp_number_exp_ctx(struct tnp_context* ctx, struct tnp_number* a);
+
+struct tnp_number* tnp_number_log(struct tnp_number* a);
+
+struct tnp_number* tnp_number_log_ctx(struct tnp_context* ctx, struct tnp_number* a);
+
+void tnp_number_sincos(struct tnp_number* a, struct tnp_number** sin, struct tnp_number** cos);
+
+void tnp_number_sincos_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number** sin, struct tnp_number** cos);
+
+void tnp_number_sinhcosh(struct tnp_number* a, struct tnp_number** sinh, struct tnp_number** cosh);
+
+void tnp_number_sinhcosh_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number** sinh, struct tnp_number** cosh);
+
+/*
+ * Target-passing variants: the result is written into target, an existing number
+ * of the same shape as the operands, instead of a new handle. The target may be one of
+ * the operands; apart from sums, differences and products this goes through scratch memory.
+ * A target of another shape is replaced by the result as by tnp_number_assign(),
+ * which allocates.
+ */
+void tnp_number_assign(struct tnp_number* target, struct tnp_number* a);
+
+void tnp_number_add_into(struct tnp_number* target, struct tnp_number* a, struct tnp_number* b);
+
+void tnp_number_add_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, struct tnp_number* b);
+
+void tnp_number_dadd_into(struct tnp_number* target, struct tnp_number* a, double b);
+
+void tnp_number_dadd_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, double b);
+
+void tnp_number_mult_into(struct tnp_number* target, struct tnp_number* a, struct tnp_number* b);
+
+void tnp_number_mult_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, struct tnp_number* b);
+
+void tnp_number_dmult_into(struct tnp_number* target, struct tnp_number* a, double b);
+
+void tnp_number_dmult_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, double b);
+
+void tnp_number_sub_into(struct tnp_number* target, struct tnp_number* a, struct tnp_number* b);
+
+void tnp_number_sub_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, struct tnp_number* b);
+
+void tnp_number_dsub_into(struct tnp_number* target, struct tnp_number* a, double b);
+
+void tnp_number_dsub_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, double b);
+
+void tnp_number_pow_into(struct tnp_number* target, struct tnp_number* a, int power);
+
+void tnp_number_pow_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, int power);
+
+void tnp_number_powr_into(struct tnp_number* target, struct tnp_number* a, double power);
+
+void tnp_number_powr_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, double power);
+
+void tnp_number_npow_into(struct tnp_number* target, struct tnp_number* a, struct tnp_number* b);
+
+void tnp_number_npow_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, struct tnp_number* b);
+
+void tnp_number_atan2_into(struct tnp_number* target, struct tnp_number* y, struct tnp_number* x);
+
+void tnp_number_atan2_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* y, struct tnp_number* x);
+
+void tnp_number_hypot_into(struct tnp_number* target, struct tnp_number* x, struct tnp_number* y);
+
+void tnp_number_hypot_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* x, struct tnp_number* y);
+
+void tnp_number_sqrt_into(struct tnp_number* target, struct tnp_number* a);
+
+void tnp_number_sqrt_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a);
+
+void tnp_number_cbrt_into(struct tnp_number* target, struct tnp_number* a);
+
+void tnp_number_cbrt_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a);
+
+/*
+ * an unknown id fills target with NaN
+ */
+void tnp_number_apply_into(struct tnp_number* target, struct tnp_number* a, int function);
+
+void tnp_number_apply_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, int function);
+
+void tnp_number_exp_into(struct tnp_number* target, struct tnp_number* a);
+
+void tnp_number_exp_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a);
+
+void tnp_number_log_into(struct tnp_number* target, struct tnp_number* a);
+
+void tnp_number_log_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a);
+
+void tnp_number_sincos_into(struct tnp_number* sin, struct tnp_number* cos, struct tnp_number* a);
+
+void tnp_number_sincos_into_ctx(struct tnp_context* ctx, struct tnp_number* sin, struct tnp_number* cos, struct tnp_number* a);
+
+void tnp_number_sinhcosh_into(struct tnp_number* sinh, struct tnp_number* cosh, struct tnp_number* a);
+
+void tnp_number_sinhcosh_into_ctx(struct tnp_context* ctx, struct tnp_number* sinh, struct tnp_number* cosh, struct tnp_number* a);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_ALIGNED_NPNUMBER_HPP
+#define TNP_ALIGNED_NPNUMBER_HPP 1
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <ostream>
+
+#include <tnp/npnumber.hpp>
+#include <tnp/npnumberview.hpp>
+#include <tnp/ops/multiplication.hpp>
+
+namespace tnp {
+
+  /**
+   * alignment of the storage of an AlignedNPNumber, a cache line
+   */
+  const std::size_t FIELD_ALIGNMENT = 64;
+
+  /**
+   * doubles per vector register of the target the library is compiled for
+   */
+#if defined(__AVX512F__)
+  const unsigned int VECTOR_DOUBLES = 8;
+#elif defined(__AVX__)
+  const unsigned int VECTOR_DOUBLES = 4;
+#else
+  const unsigned int VECTOR_DOUBLES = 2;
+#endif
+
+  /**
+   * the row stride of the padded layout: width rounded up to a multiple of VECTOR_DOUBLES
+   */
+  inline unsigned int paddedStride(unsigned int width) {
+    return (width + VECTOR_DOUBLES - 1) / VECTOR_DOUBLES * VECTOR_DOUBLES;
+  }
+
+  /**
+   * std allocator returning FIELD_ALIGNMENT aligned blocks. The block of the system allocator
+   * is over-allocated and its address is kept in front of the aligned one.
+   */
+  template<class T> class AlignedAllocator {
+  public:
+    typedef T value_type;
+
+    AlignedAllocator() {}
+
+    template<class U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+      char* raw = static_cast<char*>(::operator new(n * sizeof(T) + FIELD_ALIGNMENT + sizeof(void*)));
+      const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(raw + sizeof(void*));
+      char* aligned = raw + sizeof(void*) + (FIELD_ALIGNMENT - first % FIELD_ALIGNMENT) % FIELD_ALIGNMENT;
+      reinterpret_cast<void**>(aligned)[-1] = raw;
+      return reinterpret_cast<T*>(aligned);
+    }
+
+    void deallocate(T* p, std::size_t) {
+      ::operator delete(reinterpret_cast<void**>(p)[-1]);
+    }
+
+    template<class U> struct rebind { typedef AlignedAllocator<U> other; };
+
+    template<class U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template<class U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+  };
+
+  /**
+   * An AD-number in the padded layout: the storage is FIELD_ALIGNMENT aligned and
+   * row n starts at n*stride() with stride() = paddedStride(params+1), so every row starts
+   * on a vector boundary and SIMD loops over a row need neither unaligned loads nor scalar tails.
+   * The padding fields start out zero, they never reach the fields of the number
+   * and are ignored by all accessors and conversions.
+   * view() exposes the number to the destination passing operations of NPNumberView,
+   * toNPNumber() and copyTo() convert to the packed layout.
+   */
+  class AlignedNPNumber {
+    unsigned int _params;
+    unsigned int _order;
+    unsigned int _stride;
+    std::vector<double, AlignedAllocator<double> > values;
+
+  public:
+    AlignedNPNumber(unsigned int params, unsigned int order) :
+      _params(params), _order(order), _stride(paddedStride(params + 1)),
+      values(_stride * (order + 1), 0.0) {}
+
+    /**
+     * a constant
+     */
+    AlignedNPNumber(unsigned int params, unsigned int order, double value) :
+      _params(params), _order(order), _stride(paddedStride(params + 1)),
+      values(_stride * (order + 1), 0.0) {
+      values[0] = value;
+    }
+
+    /**
+     * pads the fields of a packed number or of any view
+     */
+    explicit AlignedNPNumber(const ConstNPNumberView& n) :
+      _params(n.params()), _order(n.order()), _stride(paddedStride(n.params() + 1)),
+      values(_stride * (n.order() + 1), 0.0) {
+      view().assign(n);
+    }
+
+    unsigned int params() const { return _params; }
+    unsigned int order() const { return _order; }
+    unsigned int stride() const { return _stride; }
+    unsigned int width() const { return _params + 1; }
+
+    const double* data() const { return values.data(); }
+    double* data() { return values.data(); }
+
+    inline double der(const unsigned int param, const unsigned int order) const {
+      return values[_stride*order + param];
+    }
+
+    inline double& der(const unsigned int param, const unsigned int order) {
+      return values[_stride*order + param];
+    }
+
+    NPNumberView view() { return NPNumberView(values.data(), _params, _order, _stride); }
+
+    ConstNPNumberView view() const { return ConstNPNumberView(values.data(), _params, _order, _stride); }
+
+    operator ConstNPNumberView() const { return view(); }
+
+    /**
+     * the fields in the packed layout of NPNumber
+     */
+    NPNumber toNPNumber() const { return view().toNPNumber(); }
+
+    /**
+     * writes the fields without padding into dst
+     */
+    void copyTo(double* dst) const { view().copyTo(dst); }
+
+    bool operator==(const AlignedNPNumber& o) const { return view() == o.view(); }
+
+    /* the linear operations run over whole rows including the padding */
+    AlignedNPNumber& operator+=(const AlignedNPNumber& o) {
+      for (std::size_t i = 0; i < values.size(); ++i)
+	values[i] += o.values[i];
+      return *this;
+    }
+
+    AlignedNPNumber& operator+=(const double o) {
+      values[0] += o;
+      return *this;
+    }
+
+    AlignedNPNumber& operator-=(const AlignedNPNumber& o) {
+      for (std::size_t i = 0; i < values.size(); ++i)
+	values[i] -= o.values[i];
+      return *this;
+    }
+
+    AlignedNPNumber& operator-=(const double o) {
+      values[0] -= o;
+      return *this;
+    }
+
+    AlignedNPNumber& operator*=(const double f) {
+      for (std::size_t i = 0; i < values.size(); ++i)
+	values[i] *= f;
+      return *this;
+    }
+
+    AlignedNPNumber operator+(const AlignedNPNumber& o) const { return AlignedNPNumber(*this) += o; }
+
+    AlignedNPNumber operator+(const double o) const { return AlignedNPNumber(*this) += o; }
+
+    AlignedNPNumber operator-(const AlignedNPNumber& o) const { return AlignedNPNumber(*this) -= o; }
+
+    AlignedNPNumber operator-(const double o) const { return AlignedNPNumber(*this) -= o; }
+
+    AlignedNPNumber operator*(const double f) const { return AlignedNPNumber(*this) *= f; }
+
+    AlignedNPNumber operator*(const AlignedNPNumber& o) const {
+      AlignedNPNumber res(_params, _order);
+      Multiplication::ensureExistance(_order).applyPadded(values.data(), o.values.data(), res.values.data(),
+							   _params + 1, _stride);
+      return res;
+    }
+
+    AlignedNPNumber& operator*=(const AlignedNPNumber& o) {
+      return *this = *this * o;
+    }
+  };
+
+  inline std::ostream& operator<<(std::ostream& out, const AlignedNPNumber& n) {
+    return out << n.toNPNumber();
+  }
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_CONTEXT_H
+#define TNP_CONTEXT_H 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+   * Evaluation state of one solver thread: warm tables, scratch memory,
+   * an allocator for handles and the integer power method.
+   * The *_ctx variants of tnp.h and tnp/ops.h take a context, the plain functions
+   * use the default context of the calling thread. A context must only be used
+   * by one thread at a time.
+   */
+  struct tnp_context;
+
+  /**
+   * a context with tables prepared up to the given order and its own allocator,
+   * NULL for a negative order
+   */
+  struct tnp_context* tnp_context_create(int order);
+
+  void tnp_context_delete(struct tnp_context* ctx);
+
+  /**
+   * the context of the calling thread used by the functions without _ctx
+   */
+  struct tnp_context* tnp_context_default(void);
+
+  /**
+   * prepares the tables up to the given order, later calls up to that order do not touch shared state.
+   * Negative orders are ignored.
+   */
+  void tnp_context_prepare(struct tnp_context* ctx, int order);
+
+  /**
+   * the integer power method of this context, see op_pow_method
+   */
+  void tnp_context_pow_method(struct tnp_context* ctx, int method);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_CONTEXT_HPP
+#define TNP_CONTEXT_HPP 1
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <atomic>
+
+#include <tnp/context.h>
+#include <tnp/pool.hpp>
+#include <tnp/ops/multiplication.hpp>
+#include <tnp/ops/composition.hpp>
+#include <tnp/ops/power.hpp>
+
+namespace tnp {
+
+  using namespace tnp::ops;
+
+  /**
+   * The state behind a tnp_context. The Multiplication and Composition tables are shared by all
+   * contexts and grow under their own locks without moving their entries. Once a context is
+   * prepared for an order, its calls up to that order read the tables without locking and keep their
+   * intermediates in the scratch memory of the context.
+   */
+  class Context {
+    int prepared;
+    std::vector<const Composition*> compositions;
+    std::vector<double> scratchFields;
+    std::unique_ptr<Pool> pool;
+    std::atomic<PowerMethod> method;
+    const bool isDefault;
+
+  public:
+    /**
+     * tag of the default context of a thread, which uses the pool of the thread and Power::method()
+     */
+    struct Default {};
+
+    explicit Context(Default);
+
+    /**
+     * a context with its own pool, prepared up to the given order
+     */
+    explicit Context(unsigned int order = 0);
+
+    /**
+     * the default context of the calling thread
+     */
+    static Context& local();
+
+    /**
+     * warms the shared tables up to the given order
+     */
+    void prepare(unsigned int order);
+
+    inline void ensure(unsigned int order) {
+      if ((int) order > prepared)
+	prepare(order);
+    }
+
+    inline const Multiplication& multiplication(unsigned int order) {
+      ensure(order);
+      return Multiplication::cacheVector()[order];
+    }
+
+    inline const Composition& composition(unsigned int order) {
+      ensure(order);
+      return *compositions[order];
+    }
+
+    /**
+     * at least n fields of scratch memory, valid until the next call
+     */
+    inline double* scratch(std::size_t n) {
+      if (scratchFields.size() < n)
+	scratchFields.resize(n);
+      return scratchFields.data();
+    }
+
+    inline void* allocate(std::size_t bytes) {
+      return pool ? pool->allocate(bytes) : Pool::acquire(bytes);
+    }
+
+    inline void deallocate(void* p, std::size_t bytes) {
+      if (pool)
+	pool->deallocate(p, bytes);
+      else
+	Pool::recycle(p, bytes);
+    }
+
+    /**
+     * the integer power method, the default context shares Power::method()
+     */
+    inline std::atomic<PowerMethod>& powerMethod() {
+      return isDefault ? Power::method() : method;
+    }
+  };
+}
+
+struct tnp_context : public tnp::Context {
+  tnp_context(unsigned int order) : Context(order) {}
+  tnp_context(Default d) : Context(d) {}
+};
+
+#endif
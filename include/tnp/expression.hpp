@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_EXPRESSION_HPP
+#define TNP_EXPRESSION_HPP 1
+
+#include <vector>
+#include <utility>
+
+#include <tnp/npnumber.hpp>
+
+/**
+ * Optional expression templates over NPNumber.
+ * An expression is started with lazy(x) and evaluated with eval(), e.g.
+ *   eval(lazy(a) * b + lazy(c) * d - lazy(e) * 2.0)
+ * Sums, differences and scalings of numbers are fused into a single sweep over
+ * the fields, products accumulate directly into the result buffer.
+ * Operands are referenced, not copied, so an expression must not outlive them.
+ */
+namespace tnp {
+  namespace expr {
+
+    template<class E> class Expression {
+    public:
+      const E& self() const { return static_cast<const E&>(*this); }
+    };
+
+    template<class E> NPNumber eval(const Expression<E>& e);
+
+    /**
+     * target += factor * e, as one loop for linear expressions and term by term otherwise
+     */
+    template<bool linear> struct Accumulate {
+      template<class E> static void apply(const E& e, double* target, double factor) {
+	e.accumulateTerms(target, factor);
+      }
+    };
+
+    template<> struct Accumulate<true> {
+      template<class E> static void apply(const E& e, double* target, double factor) {
+	const unsigned int size = e.size();
+	for (unsigned int i = 0; i < size; ++i)
+	  target[i] += factor * e.at(i);
+      }
+    };
+
+    /**
+     * a leaf, referencing the fields of an NPNumber
+     */
+    class Ref : public Expression<Ref> {
+      const NPNumber* number;
+      const double* fields;
+
+    public:
+      static const bool linear = true;
+
+      explicit Ref(const NPNumber& n) : number(&n), fields(n.data().data()) {}
+
+      unsigned int params() const { return number->params(); }
+      unsigned int order() const { return number->order(); }
+      unsigned int size() const { return (params() + 1) * (order() + 1); }
+
+      const double* data() const { return fields; }
+
+      double at(unsigned int i) const { return fields[i]; }
+
+      void accumulate(double* target, double factor) const {
+	Accumulate<true>::apply(*this, target, factor);
+      }
+    };
+
+    /**
+     * l + sign * r
+     */
+    template<class L, class R> class Sum : public Expression<Sum<L, R> > {
+      const L l;
+      const R r;
+      const double sign;
+
+    public:
+      static const bool linear = L::linear && R::linear;
+
+      Sum(const L& l, const R& r, double sign) : l(l), r(r), sign(sign) {}
+
+      unsigned int params() const { return l.params(); }
+      unsigned int order() const { return l.order(); }
+      unsigned int size() const { return l.size(); }
+
+      double at(unsigned int i) const { return l.at(i) + sign * r.at(i); }
+
+      void accumulateTerms(double* target, double factor) const {
+	l.accumulate(target, factor);
+	r.accumulate(target, factor * sign);
+      }
+
+      void accumulate(double* target, double factor) const {
+	Accumulate<linear>::apply(*this, target, factor);
+      }
+    };
+
+    /**
+     * s * e for a scalar s
+     */
+    template<class E> class Scale : public Expression<Scale<E> > {
+      const E e;
+      const double s;
+
+    public:
+      static const bool linear = E::linear;
+
+      Scale(const E& e, double s) : e(e), s(s) {}
+
+      unsigned int params() const { return e.params(); }
+      unsigned int order() const { return e.order(); }
+      unsigned int size() const { return e.size(); }
+
+      double at(unsigned int i) const { return s * e.at(i); }
+
+      void accumulateTerms(double* target, double factor) const {
+	e.accumulate(target, factor * s);
+      }
+
+      void accumulate(double* target, double factor) const {
+	Accumulate<linear>::apply(*this, target, factor);
+      }
+    };
+
+    /**
+     * the fields of a factor: leaves are used directly, other expressions are evaluated once
+     */
+    template<class E> class Operand {
+      const NPNumber value;
+
+    public:
+      Operand(const E& e) : value(eval(e)) {}
+
+      const double* data() const { return value.data().data(); }
+    };
+
+    template<> class Operand<Ref> {
+      const double* fields;
+
+    public:
+      Operand(const Ref& r) : fields(r.data()) {}
+
+      const double* data() const { return fields; }
+    };
+
+    /**
+     * l * r, accumulated directly into the target by Multiplication
+     */
+    template<class L, class R> class Product : public Expression<Product<L, R> > {
+      const unsigned int _params;
+      const unsigned int _order;
+      const Operand<L> l;
+      const Operand<R> r;
+
+    public:
+      static const bool linear = false;
+
+      Product(const L& l, const R& r) : _params(l.params()), _order(l.order()), l(l), r(r) {}
+
+      unsigned int params() const { return _params; }
+      unsigned int order() const { return _order; }
+      unsigned int size() const { return (_params + 1) * (_order + 1); }
+
+      void accumulateTerms(double* target, double factor) const {
+	Multiplication::ensureExistance(_order).accumulate(l.data(), r.data(), target, factor, _params + 1);
+      }
+
+      void accumulate(double* target, double factor) const {
+	Accumulate<linear>::apply(*this, target, factor);
+      }
+    };
+
+    /**
+     * starts an expression
+     */
+    inline Ref lazy(const NPNumber& n) { return Ref(n); }
+
+    /**
+     * evaluates an expression into a new number, allocating only its result
+     */
+    template<class E> NPNumber eval(const Expression<E>& e) {
+      const E& x = e.self();
+      FieldVector target(x.size(), 0.0);
+      x.accumulate(target.data(), 1.0);
+      return NPNumber(x.params() + 1, std::move(target));
+    }
+
+    /* operators */
+    template<class L, class R> Sum<L, R> operator+(const Expression<L>& l, const Expression<R>& r) {
+      return Sum<L, R>(l.self(), r.self(), 1.0);
+    }
+
+    template<class L> Sum<L, Ref> operator+(const Expression<L>& l, const NPNumber& r) {
+      return Sum<L, Ref>(l.self(), Ref(r), 1.0);
+    }
+
+    template<class R> Sum<Ref, R> operator+(const NPNumber& l, const Expression<R>& r) {
+      return Sum<Ref, R>(Ref(l), r.self(), 1.0);
+    }
+
+    template<class L, class R> Sum<L, R> operator-(const Expression<L>& l, const Expression<R>& r) {
+      return Sum<L, R>(l.self(), r.self(), -1.0);
+    }
+
+    template<class L> Sum<L, Ref> operator-(const Expression<L>& l, const NPNumber& r) {
+      return Sum<L, Ref>(l.self(), Ref(r), -1.0);
+    }
+
+    template<class R> Sum<Ref, R> operator-(const NPNumber& l, const Expression<R>& r) {
+      return Sum<Ref, R>(Ref(l), r.self(), -1.0);
+    }
+
+    template<class E> Scale<E> operator*(const Expression<E>& e, double s) {
+      return Scale<E>(e.self(), s);
+    }
+
+    template<class E> Scale<E> operator*(double s, const Expression<E>& e) {
+      return Scale<E>(e.self(), s);
+    }
+
+    template<class L, class R> Product<L, R> operator*(const Expression<L>& l, const Expression<R>& r) {
+      return Product<L, R>(l.self(), r.self());
+    }
+
+    template<class L> Product<L, Ref> operator*(const Expression<L>& l, const NPNumber& r) {
+      return Product<L, Ref>(l.self(), Ref(r));
+    }
+
+    template<class R> Product<Ref, R> operator*(const NPNumber& l, const Expression<R>& r) {
+      return Product<Ref, R>(Ref(l), r.self());
+    }
+  }
+}
+#endif
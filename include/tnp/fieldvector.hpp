@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_FIELD_VECTOR_HPP
+#define TNP_FIELD_VECTOR_HPP 1
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <tnp/pool.hpp>
+
+namespace tnp {
+
+  /**
+   * The fields of an NPNumber. Up to INLINE_FIELDS doubles (e.g. 3 params at order 3)
+   * are stored inline, larger numbers spill to a heap vector drawn from the Pool of the thread,
+   * so numbers of a recurring shape do not reach the system allocator. Provides the read
+   * interface of std::vector<double> that NPNumber::data() used to expose.
+   */
+  class FieldVector {
+  public:
+    static const std::size_t INLINE_FIELDS = 16;
+
+    typedef double value_type;
+    typedef double* iterator;
+    typedef const double* const_iterator;
+    typedef std::size_t size_type;
+
+  private:
+    std::size_t n;
+    double local[INLINE_FIELDS];
+    typedef std::vector<double, PoolAllocator<double> > Heap;
+    Heap heap;
+
+    inline bool isInline() const { return n <= INLINE_FIELDS; }
+
+    /**
+     * copies the n inline fields of an inline vector, the rest of the block is never initialized
+     */
+    inline void copyLocal(const FieldVector& o) {
+      std::memcpy(local, o.local, o.n * sizeof(double));
+    }
+
+  public:
+    /**
+     * tag for sizing a vector without initializing its fields
+     */
+    struct Uninitialized {};
+
+    FieldVector() : n(0) {}
+
+    FieldVector(std::size_t size, Uninitialized) : n(size) {
+      if (!isInline())
+	heap.resize(size);
+    }
+
+    explicit FieldVector(std::size_t size, double value = 0.0) : n(size) {
+      if (!isInline())
+	heap.assign(size, value);
+      else
+	std::fill(local, local + size, value);
+    }
+
+    FieldVector(const std::vector<double>& v) : n(v.size()) {
+      if (!isInline())
+	heap.assign(v.begin(), v.end());
+      else
+	std::copy(v.begin(), v.end(), local);
+    }
+
+    FieldVector(const FieldVector& o) : n(o.n) {
+      if (!isInline())
+	heap = o.heap;
+      else
+	copyLocal(o);
+    }
+
+    FieldVector(FieldVector&& o) : n(o.n) {
+      if (!isInline()) {
+	heap = std::move(o.heap);
+	o.n = 0;
+      } else
+	copyLocal(o);
+    }
+
+    /* assignments reuse the existing heap storage where possible */
+    FieldVector& operator=(const FieldVector& o) {
+      if (this == &o)
+	return *this;
+
+      if (!o.isInline()) {
+	heap = o.heap;
+	n = o.n;
+      } else {
+	n = o.n;
+	copyLocal(o);
+      }
+      return *this;
+    }
+
+    FieldVector& operator=(FieldVector&& o) {
+      if (!o.isInline()) {
+	heap = std::move(o.heap);
+	n = o.n;
+	o.n = 0;
+      } else {
+	n = o.n;
+	copyLocal(o);
+      }
+      return *this;
+    }
+
+    void assign(const double* first, const double* last) {
+      n = last - first;
+      if (!isInline()) {
+	heap.assign(first, last);
+      } else
+	std::copy(first, last, local);
+    }
+
+    void assign(std::size_t size, double value) {
+      n = size;
+      if (!isInline())
+	heap.assign(size, value);
+      else
+	std::fill(local, local + size, value);
+    }
+
+    operator std::vector<double>() const { return std::vector<double>(begin(), end()); }
+
+    inline std::size_t size() const { return n; }
+    inline bool empty() const { return n == 0; }
+
+    inline double* data() { return isInline() ? local : heap.data(); }
+    inline const double* data() const { return isInline() ? local : heap.data(); }
+
+    inline double* begin() { return data(); }
+    inline double* end() { return data() + n; }
+    inline const double* begin() const { return data(); }
+    inline const double* end() const { return data() + n; }
+
+    inline double& operator[](std::size_t i) { return data()[i]; }
+    inline double operator[](std::size_t i) const { return data()[i]; }
+
+    bool operator==(const FieldVector& o) const {
+      return n == o.n && std::equal(begin(), end(), o.begin());
+    }
+
+    bool operator!=(const FieldVector& o) const { return !(*this == o); }
+  };
+}
+
+#endif
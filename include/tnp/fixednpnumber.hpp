@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_FIXED_NPNUMBER_HPP
+#define TNP_FIXED_NPNUMBER_HPP 1
+
+#include <array>
+#include <vector>
+#include <algorithm>
+
+#include <tnp/npnumber.hpp>
+#include <tnp/ops/fixed.hpp>
+
+namespace tnp {
+
+  using namespace tnp::ops;
+
+  /**
+   * An AD-number with P parameters and order O fixed at compile time.
+   * The fields live in a std::array in the same layout as NPNumber and the
+   * op_tnp_number_* buffers, so data() can be handed to those directly.
+   * Products use FixedMultiplication, the elementary functions and compositions
+   * use the runtime kernels on the array without allocating a result vector.
+   */
+  template<unsigned int P, unsigned int O> class FixedNPNumber {
+  public:
+    static const unsigned int width = P + 1;
+    static const unsigned int size = (P + 1) * (O + 1);
+
+  private:
+    std::array<double, size> values;
+
+  public:
+    FixedNPNumber() { values.fill(0.0); }
+
+    /**
+     * a constant
+     */
+    explicit FixedNPNumber(double value) {
+      values.fill(0.0);
+      values[0] = value;
+    }
+
+    /**
+     * copies size fields from a raw buffer
+     */
+    explicit FixedNPNumber(const double* fields) {
+      std::copy(fields, fields + size, values.begin());
+    }
+
+    /**
+     * copies a dynamic number. Of a number of another shape only the parameters and orders
+     * both have are copied, the others are 0.
+     */
+    explicit FixedNPNumber(const NPNumber& n) {
+      if (n.params() == P && n.order() == O && !n.isConstant()) {
+	std::copy(n.data().begin(), n.data().end(), values.begin());
+	return;
+      }
+
+      values.fill(0.0);
+      const unsigned int params = std::min(n.params(), P);
+      const unsigned int order = std::min(n.order(), O);
+      for (unsigned int o = 0; o <= order; ++o)
+	for (unsigned int p = 0; p <= params; ++p)
+	  values[width*o + p] = n.der(p, o);
+    }
+
+    NPNumber toNPNumber() const {
+      FieldVector fields(values.size(), FieldVector::Uninitialized());
+      std::copy(values.begin(), values.end(), fields.begin());
+      return NPNumber(width, std::move(fields));
+    }
+
+    void copyTo(double* fields) const {
+      std::copy(values.begin(), values.end(), fields);
+    }
+
+    unsigned int order() const { return O; }
+    unsigned int params() const { return P; }
+
+    const double* data() const { return values.data(); }
+    double* data() { return values.data(); }
+
+    inline double der(const unsigned int param, const unsigned int order) const {
+      return values[width*order + param];
+    }
+
+    inline double& der(const unsigned int param, const unsigned int order) {
+      return values[width*order + param];
+    }
+
+    bool operator==(const FixedNPNumber& o) const {
+      return values == o.values;
+    }
+
+    /* addition */
+    FixedNPNumber& operator+=(const FixedNPNumber& o) {
+      for (unsigned int i = 0; i < size; ++i)
+	values[i] += o.values[i];
+      return *this;
+    }
+
+    FixedNPNumber& operator+=(const double o) {
+      values[0] += o;
+      return *this;
+    }
+
+    FixedNPNumber& operator-=(const FixedNPNumber& o) {
+      for (unsigned int i = 0; i < size; ++i)
+	values[i] -= o.values[i];
+      return *this;
+    }
+
+    FixedNPNumber& operator-=(const double o) {
+      values[0] -= o;
+      return *this;
+    }
+
+    FixedNPNumber operator+(const FixedNPNumber& o) const { return FixedNPNumber(*this) += o; }
+
+    FixedNPNumber operator+(const double o) const { return FixedNPNumber(*this) += o; }
+
+    FixedNPNumber operator-(const FixedNPNumber& o) const { return FixedNPNumber(*this) -= o; }
+
+    FixedNPNumber operator-(const double o) const { return FixedNPNumber(*this) -= o; }
+
+    /* multiplication */
+    FixedNPNumber operator*(const FixedNPNumber& o) const {
+      FixedNPNumber res;
+      FixedMultiplication<P, O>::apply(values.data(), o.values.data(), res.values.data());
+      return res;
+    }
+
+    FixedNPNumber& operator*=(const FixedNPNumber& o) {
+      return *this = *this * o;
+    }
+
+    FixedNPNumber& operator*=(const double f) {
+      for (unsigned int i = 0; i < size; ++i)
+	values[i] *= f;
+      return *this;
+    }
+
+    FixedNPNumber operator*(const double f) const { return FixedNPNumber(*this) *= f; }
+
+    /* unary functions */
+    FixedNPNumber pow(int n) const {
+      FixedNPNumber res;
+      Power::apply(n, values.data(), res.values.data(), O, width, Power::method());
+      return res;
+    }
+
+    FixedNPNumber pow(double alpha) const {
+      FixedNPNumber res;
+      Elementary::pow(values.data(), res.values.data(), alpha, O, width);
+      return res;
+    }
+
+    FixedNPNumber sqrt() const {
+      FixedNPNumber res;
+      Elementary::sqrt(values.data(), res.values.data(), O, width);
+      return res;
+    }
+
+    FixedNPNumber exp() const {
+      FixedNPNumber res;
+      Elementary::exp(values.data(), res.values.data(), O, width);
+      return res;
+    }
+
+    FixedNPNumber log() const {
+      FixedNPNumber res;
+      Elementary::log(values.data(), res.values.data(), O, width);
+      return res;
+    }
+
+    std::pair<FixedNPNumber, FixedNPNumber> sincos() const {
+      std::pair<FixedNPNumber, FixedNPNumber> res;
+      Elementary::sincos(values.data(), res.first.values.data(), res.second.values.data(), O, width);
+      return res;
+    }
+
+    /**
+     * applies a function given by its O+2 derivatives at the value of this number
+     */
+    FixedNPNumber compose(const double* f) const {
+      FixedNPNumber res;
+      CompositionCache::staticGetInstance(O)->apply(f, values.data(), res.values.data(), width);
+      return res;
+    }
+
+    FixedNPNumber apply(const UnaryFunction& f) const {
+      FixedNPNumber res;
+      f.apply(values.data(), res.values.data(), O, width);
+      return res;
+    }
+
+    /**
+     * the free variable t with the given value, see NPNumber::freeVar
+     */
+    static FixedNPNumber freeVar(double value) {
+      FixedNPNumber num(value);
+      if (O > 0)
+	num.values[width] = 1.0;
+      return num;
+    }
+  };
+
+  template<unsigned int P, unsigned int O>
+  std::ostream& operator<<(std::ostream& out, const FixedNPNumber<P, O>& n) {
+    return out << n.toNPNumber();
+  }
+}
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_GENERIC_NPNUMBER_HPP
+#define TNP_GENERIC_NPNUMBER_HPP 1
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+#include <tnp/npnumber.hpp>
+#include <tnp/ops/multiplication.hpp>
+#include <tnp/ops/composition.hpp>
+
+namespace tnp {
+
+  using namespace tnp::ops;
+
+  /**
+   * An AD-number whose fields are of scalar type T, in the layout of NPNumber.
+   * Products and compositions sum their terms in Acc, so GenericNPNumber<float, double>
+   * stores floats (half the memory traffic) but rounds only once per field.
+   * T and Acc are limited to the instantiations of Multiplication::applyScalar:
+   * float, float/double, double and long double.
+   * NPNumber stays the double implementation with all functions and the fixed-shape kernels.
+   */
+  template<class T, class Acc = T> class GenericNPNumber {
+    unsigned int _order;
+    unsigned int width;
+    std::vector<T> values;
+
+  public:
+    typedef T value_type;
+    typedef Acc accumulator_type;
+
+    GenericNPNumber() : _order(0), width(1), values(1, T(0)) {}
+
+    GenericNPNumber(unsigned int params, unsigned int order) : _order(order), width(params+1),
+							       values(width*(order+1), T(0)) {}
+
+    /**
+     * a constant
+     */
+    GenericNPNumber(unsigned int params, unsigned int order, T value) : _order(order), width(params+1),
+									values(width*(order+1), T(0)) {
+      values[0] = value;
+    }
+
+    GenericNPNumber(unsigned int width, const std::vector<T>& values) : _order(values.size() / width - 1),
+									 width(width), values(values) {}
+
+    /**
+     * rounds the fields of a double number to T
+     */
+    explicit GenericNPNumber(const NPNumber& n) : _order(n.order()), width(n.params()+1),
+						  values(n.data().begin(), n.data().end()) {}
+
+    NPNumber toNPNumber() const {
+      FieldVector fields(values.size(), FieldVector::Uninitialized());
+      std::copy(values.begin(), values.end(), fields.begin());
+      return NPNumber(width, std::move(fields));
+    }
+
+    unsigned int order() const { return _order; }
+    unsigned int params() const { return width - 1; }
+
+    const std::vector<T>& data() const { return values; }
+
+    inline T der(const unsigned int param, const unsigned int order) const {
+      return values[width*order + param];
+    }
+
+    inline T& der(const unsigned int param, const unsigned int order) {
+      return values[width*order + param];
+    }
+
+    bool operator==(const GenericNPNumber& o) const {
+      return width == o.width && values == o.values;
+    }
+
+    /* addition */
+    GenericNPNumber& operator+=(const GenericNPNumber& o) {
+      for (unsigned int i = 0; i < values.size(); ++i)
+	values[i] += o.values[i];
+      return *this;
+    }
+
+    GenericNPNumber& operator+=(const T o) {
+      values[0] += o;
+      return *this;
+    }
+
+    GenericNPNumber& operator-=(const GenericNPNumber& o) {
+      for (unsigned int i = 0; i < values.size(); ++i)
+	values[i] -= o.values[i];
+      return *this;
+    }
+
+    GenericNPNumber& operator-=(const T o) {
+      values[0] -= o;
+      return *this;
+    }
+
+    GenericNPNumber operator+(const GenericNPNumber& o) const { return GenericNPNumber(*this) += o; }
+
+    GenericNPNumber operator+(const T o) const { return GenericNPNumber(*this) += o; }
+
+    GenericNPNumber operator-(const GenericNPNumber& o) const { return GenericNPNumber(*this) -= o; }
+
+    GenericNPNumber operator-(const T o) const { return GenericNPNumber(*this) -= o; }
+
+    /* multiplication */
+    GenericNPNumber operator*(const GenericNPNumber& o) const {
+      GenericNPNumber res(params(), _order);
+      Multiplication::ensureExistance(_order).template applyScalar<T, Acc>(values.data(), o.values.data(),
+									    res.values.data(), width);
+      return res;
+    }
+
+    GenericNPNumber& operator*=(const GenericNPNumber& o) {
+      return *this = *this * o;
+    }
+
+    GenericNPNumber& operator*=(const T f) {
+      for (unsigned int i = 0; i < values.size(); ++i)
+	values[i] *= f;
+      return *this;
+    }
+
+    GenericNPNumber operator*(const T f) const { return GenericNPNumber(*this) *= f; }
+
+    /**
+     * applies a function given by its order+2 derivatives at the value of this number
+     */
+    GenericNPNumber compose(const std::vector<Acc>& f) const {
+      GenericNPNumber res(params(), _order);
+      CompositionCache::staticGetInstance(_order)->template applyScalar<T, Acc>(f.data(), values.data(),
+										res.values.data(), width);
+      return res;
+    }
+
+    GenericNPNumber exp() const {
+      return compose(std::vector<Acc>(_order + 2, std::exp(Acc(values[0]))));
+    }
+
+    GenericNPNumber log() const {
+      // d^n/dx^n log(x) = (-1)^(n-1) (n-1)! / x^n
+      const Acc x = values[0];
+      std::vector<Acc> f(_order + 2);
+      f[0] = std::log(x);
+      Acc d = 1 / x;
+      for (unsigned int n = 1; n < f.size(); ++n) {
+	f[n] = d;
+	d *= -Acc(n) / x;
+      }
+      return compose(f);
+    }
+  };
+
+  typedef GenericNPNumber<float> FloatNPNumber;
+  typedef GenericNPNumber<float, double> MixedNPNumber;
+  typedef GenericNPNumber<long double> LongNPNumber;
+
+  template<class T, class Acc>
+  std::ostream& operator<<(std::ostream& out, const GenericNPNumber<T, Acc>& n) {
+    return out << n.toNPNumber();
+  }
+}
+
+#endif
@@ -22,9 +22,15 @@
 #include <iostream>
 #include <vector>
 #include <iterator>
+#include <utility>
+#include <atomic>
 
+#include <tnp/fieldvector.hpp>
 #include <tnp/ops/multiplication.hpp>
 #include <tnp/ops/composition.hpp>
+#include <tnp/ops/elementary.hpp>
+#include <tnp/ops/functions.hpp>
+#include <tnp/ops/power.hpp>
 
 namespace tnp {
   
@@ -43,32 +49,148 @@ namespace tnp {
 
   /**
    * An AD-number of arbitrary width and depth
+   * Constants (all derivatives = 0) only store their value, arithmetic on them 
+   * reduces to scalar operations. The full field vector is built lazily, once 
+   * it is actually requested. It is built at most once and under a lock, so a constant
+   * may be read by several threads like any other number.
    */
   class NPNumber {
     unsigned int _order;
     unsigned int width;
-    std::vector<double> values;    
+    mutable FieldVector values;    
+    bool _constant;
+    /* set once the fields of a constant are built, they do not change afterwards */
+    mutable std::atomic<bool> built{false};
+    double _value;
 
     inline const Multiplication& mult() const { return Multiplication::cacheVector()[_order]; }
 
-    NPNumber() {}
+    void buildConstant() const;
+
+    /**
+     * builds the field vector of a constant, if not done yet
+     */
+    inline void materialize() const {
+      if (_constant && !built.load(std::memory_order_acquire))
+	buildConstant();
+    }
+
+    /**
+     * true if the fields of o may be copied, i.e. no other thread is about to build them
+     */
+    static inline bool settled(const NPNumber& o) {
+      return !o._constant || o.built.load(std::memory_order_acquire);
+    }
+
+    /**
+     * a constant of the same shape as this number
+     */
+    inline NPNumber constantOf(double value) const { return NPNumber(width - 1, _order, value); }
+
+    NPNumber() : _order(0), width(1), _constant(false), _value(0.0) {}
+
+    /**
+     * a number of the same shape as the given one, whose fields are all about to be overwritten
+     */
+    NPNumber(const NPNumber& shape, FieldVector::Uninitialized u) : _order(shape._order), width(shape.width),
+								    values(width * (_order+1), u),
+								    _constant(false), _value(0.0) {}
+
+    /**
+     * this = o - this, in place
+     */
+    NPNumber& subtractFrom(const NPNumber& o);
+
+    /**
+     * this = o * this, in place
+     */
+    NPNumber& multiplyFrom(const NPNumber& o);
 
   public:
     inline const Composition* comp() const { return CompositionCache::staticGetInstance(_order); }
 
     NPNumber(unsigned int params, unsigned int order) : _order(order), width(params+1), 
-							values(width * (order+1), 0.0) {
+							values(width * (order+1), 0.0),
+							_constant(false), _value(0.0) {
       Multiplication::ensureExistance(_order) ;
     }
 							
     NPNumber(unsigned int width, const std::vector<double>& values) : _order(values.size() / width - 1), 
 								      width(width), 
-								      values(values)  {
+								      values(values),
+								      _constant(false), _value(0.0) {
+      Multiplication::ensureExistance(_order) ;
+    }
+
+    NPNumber(unsigned int width, const FieldVector& values) : _order(values.size() / width - 1), 
+							      width(width), 
+							      values(values),
+							      _constant(false), _value(0.0) {
+      Multiplication::ensureExistance(_order) ;
+    }
+
+    /**
+     * takes over the given field vector, large vectors without copying them
+     */
+    NPNumber(unsigned int width, FieldVector&& values) : _order(values.size() / width - 1), 
+							 width(width), 
+							 values(std::move(values)),
+							 _constant(false), _value(0.0) {
+      Multiplication::ensureExistance(_order) ;
+    }
+
+    /**
+     * copies the fields: the heap storage of a FieldVector comes from the Pool and cannot adopt
+     * the buffer of a std::vector, whether the pool is enabled or not.
+     * Build a FieldVector and use the constructor above to avoid the copy.
+     */
+    NPNumber(unsigned int width, std::vector<double>&& values) : _order(values.size() / width - 1), 
+								 width(width), 
+								 values(values),
+								 _constant(false), _value(0.0) {
       Multiplication::ensureExistance(_order) ;
     }
     
+    /* copies of a constant whose fields are not built yet do not read them */
+    NPNumber(const NPNumber& o) : _order(o._order), width(o.width), _constant(o._constant), _value(o._value) {
+      if (settled(o)) {
+	values = o.values;
+	built.store(o._constant, std::memory_order_relaxed);
+      }
+    }
+
+    NPNumber(NPNumber&& o) : _order(o._order), width(o.width), values(std::move(o.values)),
+			     _constant(o._constant), built(o.built.load(std::memory_order_relaxed)),
+			     _value(o._value) {}
+
+    NPNumber& operator=(const NPNumber& o) {
+      if (this == &o)
+	return *this;
+      _order = o._order;
+      width = o.width;
+      _constant = o._constant;
+      _value = o._value;
+      const bool copy = settled(o);
+      values = copy ? o.values : FieldVector();
+      built.store(copy && o._constant, std::memory_order_relaxed);
+      return *this;
+    }
+
+    NPNumber& operator=(NPNumber&& o) {
+      _order = o._order;
+      width = o.width;
+      values = std::move(o.values);
+      _constant = o._constant;
+      built.store(o.built.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      _value = o._value;
+      return *this;
+    }
+
+    /**
+     * a constant, the field vector is only built on demand
+     */
     NPNumber(unsigned int params, unsigned int order, double value) : _order(order), width(params+1),
-								      values(constant(value, width * (order+1))) {
+								      _constant(true), _value(value) {
       Multiplication::ensureExistance(_order) ;
     }
     
@@ -89,67 +211,195 @@ namespace tnp {
     unsigned int order() const { return _order; }
     unsigned int params() const { return width - 1; }
 
-    const std::vector<double>& data() const { return values; }
+    /**
+     * true if all derivatives of this number are known to be 0
+     */
+    bool isConstant() const { return _constant; }
 
-    inline double der(const unsigned int param, const unsigned int order) const 
-    { return values[width*order + param]; }
+    const FieldVector& data() const { materialize(); return values; }
+
+    inline double der(const unsigned int param, const unsigned int order) const {
+      if (_constant)
+	return (param == 0 && order == 0) ? _value : 0.0;
+      return values[width*order + param];
+    }
 
     inline double& der(const unsigned int param, const unsigned int order) {
+      materialize();
+      _constant = false;
       return values[width*order + param];
     }
 
     /* operators */
     bool operator==(const NPNumber& o) const {
-      return values == o.values;
+      if (_constant && o._constant)
+	return width == o.width && _order == o._order && _value == o._value;
+      return data() == o.data();
     }
 
-    NPNumber operator+(const NPNumber& o) const {
+    /* 
+     * The rvalue overloads compute the result in the buffer of an expiring operand,
+     * so a chain of arithmetic only allocates for its first intermediate.
+     */
+    NPNumber operator+(const NPNumber& o) const & {
       return plus(o);
     }
 
-    NPNumber operator+=(const NPNumber& o);
+    NPNumber operator+(const NPNumber& o) && {
+      return std::move(*this += o);
+    }
+
+    NPNumber operator+(NPNumber&& o) const & {
+      return std::move(o += *this);
+    }
+
+    NPNumber operator+(NPNumber&& o) && {
+      return std::move(*this += o);
+    }
+
+    NPNumber& operator+=(const NPNumber& o);
 
-    NPNumber operator+=(const double o);
+    NPNumber& operator+=(const double o);
 
-    NPNumber operator+(const double o) const {
+    NPNumber operator+(const double o) const & {
       return plus(o);
     }
 
-    NPNumber operator-(const NPNumber& o) const {
+    NPNumber operator+(const double o) && {
+      return std::move(*this += o);
+    }
+
+    NPNumber operator-(const NPNumber& o) const & {
       return minus(o);
     }
 
-    NPNumber operator-(const double o) const {
+    NPNumber operator-(const NPNumber& o) && {
+      return std::move(*this -= o);
+    }
+
+    NPNumber operator-(NPNumber&& o) const & {
+      return std::move(o.subtractFrom(*this));
+    }
+
+    NPNumber operator-(NPNumber&& o) && {
+      return std::move(*this -= o);
+    }
+
+    NPNumber& operator-=(const NPNumber& o);
+
+    NPNumber& operator-=(const double o);
+
+    NPNumber operator-(const double o) const & {
       return minus(o);
     }
 
-    NPNumber operator*(const NPNumber& o) const {
+    NPNumber operator-(const double o) && {
+      return std::move(*this -= o);
+    }
+
+    NPNumber operator*(const NPNumber& o) const & {
       return times(o);
     }
 
-    NPNumber operator*(const double f) const {
+    NPNumber operator*(const NPNumber& o) && {
+      return std::move(*this *= o);
+    }
+
+    NPNumber operator*(NPNumber&& o) const & {
+      return std::move(o.multiplyFrom(*this));
+    }
+
+    NPNumber operator*(NPNumber&& o) && {
+      return std::move(*this *= o);
+    }
+
+    NPNumber operator*(const double f) const & {
       return times(f);
     }
 
-    NPNumber operator*=(const NPNumber& o);
+    NPNumber operator*(const double f) && {
+      return std::move(*this *= f);
+    }
+
+    /**
+     * multiplies in place, o may be this number itself
+     */
+    NPNumber& operator*=(const NPNumber& o);
 
-    NPNumber operator*=(const double o);
+    NPNumber& operator*=(const double o);
 
     NPNumber operator/(const NPNumber& o) const {
       //TODO
       return *this;
     }
 
-    NPNumber pow(int power) const;
+    NPNumber pow(int power) const { return pow(power, Power::method()); }
+
+    NPNumber pow(int power, PowerMethod method) const;
+
+    NPNumber pow(unsigned int power) const { return pow((int)power); }
+
+    /**
+     * real-valued power, the value of this number must not be zero
+     */
+    NPNumber pow(double power) const;
+
+    /**
+     * this number to the power of another number, the value of this number must be positive
+     */
+    NPNumber pow(const NPNumber& exponent) const;
+
+    /**
+     * atan2 with this number as y and the argument as x
+     */
+    NPNumber atan2(const NPNumber& x) const;
+
+    NPNumber hypot(const NPNumber& o) const;
+
+    NPNumber sqrt() const;
+
+    NPNumber cbrt() const;
+
+    NPNumber exp() const;
+
+    NPNumber log() const;
+
+    /**
+     * applies a function registered in the FunctionRegistry
+     */
+    NPNumber apply(unsigned int function) const;
+
+    NPNumber apply(const UnaryFunction& f) const;
+
+    /**
+     * applies several functions, given by their order+2 derivatives, to this number 
+     * while evaluating the Bell polynomials only once
+     */
+    std::vector<NPNumber> compose(const std::vector<std::vector<double>>& derivatives) const;
+
+    /**
+     * applies several registered functions to this number, see compose()
+     */
+    std::vector<NPNumber> apply(const std::vector<unsigned int>& functions) const;
+
+    /**
+     * returns (sin, cos) of this number, computed in one sweep
+     */
+    std::pair<NPNumber, NPNumber> sincos() const;
+
+    /**
+     * returns (sinh, cosh) of this number, computed in one sweep
+     */
+    std::pair<NPNumber, NPNumber> sinhcosh() const;
 
     void toParameter(unsigned int param) {
-      values[param+1] = 1.0;
+      der(param+1, 0) = 1.0;
     }
     
     NPNumber asParameter(unsigned int param) const {
-      vector<double> args(values);
-      args[param+1] = 1.0;
-      return NPNumber(width, args);
+      NPNumber res(*this);
+      res.toParameter(param);
+      return res;
     }
 
     /**
@@ -159,7 +409,7 @@ namespace tnp {
     static NPNumber freeVar(unsigned int params, unsigned int order, double value) {
       NPNumber num(params, order, value);
       if (order > 0)
-	num.values[num.width] = 1.0; //dt/dt = 1
+	num.der(0, 1) = 1.0; //dt/dt = 1
       return num;
     }
 
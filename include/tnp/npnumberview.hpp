@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_NPNUMBER_VIEW_HPP
+#define TNP_NPNUMBER_VIEW_HPP 1
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+
+#include <tnp/npnumber.hpp>
+
+namespace tnp {
+
+  using namespace tnp::ops;
+
+  /**
+   * A non-owning view of an AD-number in an external buffer, e.g. a block of a solver state vector.
+   * Row n (the n-th total derivative and its partials) starts at fields + n*stride,
+   * the stride defaults to params+1, i.e. the layout of NPNumber and the op_tnp_number_* buffers.
+   * Views never allocate for contiguous buffers. Products of disjoint views with the same padded
+   * stride (stride > params+1) run on the strided rows without touching the padding, the elementary
+   * functions and all other padded or overlapping operands are packed into a scratch buffer.
+   * The buffer must outlive the view.
+   */
+  template<class Field> class BasicNPNumberView {
+    Field* fields;
+    unsigned int _params;
+    unsigned int _order;
+    unsigned int _stride;
+
+    template<class F> friend class BasicNPNumberView;
+
+  public:
+    BasicNPNumberView(Field* fields, unsigned int params, unsigned int order) :
+      fields(fields), _params(params), _order(order), _stride(params + 1) {}
+
+    BasicNPNumberView(Field* fields, unsigned int params, unsigned int order, unsigned int stride) :
+      fields(fields), _params(params), _order(order), _stride(stride) {}
+
+    /**
+     * a read-only view of a mutable one
+     */
+    template<class F> BasicNPNumberView(const BasicNPNumberView<F>& o) :
+      fields(o.fields), _params(o._params), _order(o._order), _stride(o._stride) {}
+
+    /**
+     * a read-only view of the fields of a number, valid until the number is modified
+     */
+    template<class F = Field, class = typename std::enable_if<std::is_const<F>::value>::type>
+    BasicNPNumberView(const NPNumber& n) :
+      fields(n.data().data()), _params(n.params()), _order(n.order()), _stride(n.params() + 1) {}
+
+    unsigned int params() const { return _params; }
+    unsigned int order() const { return _order; }
+    unsigned int stride() const { return _stride; }
+    unsigned int width() const { return _params + 1; }
+
+    /**
+     * true if the rows follow each other without padding
+     */
+    bool contiguous() const { return _stride == _params + 1; }
+
+    Field* data() const { return fields; }
+
+    inline Field& der(const unsigned int param, const unsigned int order) const {
+      return fields[_stride*order + param];
+    }
+
+    /**
+     * copies the fields into a new number
+     */
+    NPNumber toNPNumber() const {
+      FieldVector values((_params + 1) * (_order + 1), FieldVector::Uninitialized());
+      copyTo(values.data());
+      return NPNumber(_params + 1, std::move(values));
+    }
+
+    /**
+     * writes the fields without padding into dst
+     */
+    void copyTo(double* dst) const {
+      const unsigned int w = _params + 1;
+      for (unsigned int n = 0; n <= _order; ++n)
+	std::copy(fields + n*_stride, fields + n*_stride + w, dst + n*w);
+    }
+
+    bool operator==(const BasicNPNumberView<const double>& o) const {
+      if (_params != o._params || _order != o._order)
+	return false;
+      for (unsigned int n = 0; n <= _order; ++n)
+	if (!std::equal(fields + n*_stride, fields + n*_stride + _params + 1, o.fields + n*o._stride))
+	  return false;
+      return true;
+    }
+
+    /**
+     * true if the fields of this view and o may share memory
+     */
+    bool overlaps(const BasicNPNumberView<const double>& o) const {
+      const double* end = fields + _order*_stride + _params + 1;
+      const double* oEnd = o.fields + o._order*o._stride + o._params + 1;
+      return std::less<const double*>()(fields, oEnd) && std::less<const double*>()(o.fields, end);
+    }
+
+    /*
+     * Destination passing arithmetic: this = f(operands).
+     * The operands must have the shape of this view, their strides may differ.
+     */
+    void assign(const BasicNPNumberView<const double>& a) const {
+      if (!fieldwise(a)) {
+	const std::vector<double> pa(packed(a));
+	assign(BasicNPNumberView<const double>(pa.data(), _params, _order));
+	return;
+      }
+      for (unsigned int n = 0; n <= _order; ++n)
+	std::copy(a.fields + n*a._stride, a.fields + n*a._stride + _params + 1, fields + n*_stride);
+    }
+
+    void constant(double value) const {
+      for (unsigned int n = 0; n <= _order; ++n)
+	std::fill(fields + n*_stride, fields + n*_stride + _params + 1, 0.0);
+      fields[0] = value;
+    }
+
+    /*
+     * the linear operations read each field right before writing it, so the destination may be an operand
+     * with the same fields and stride, operands overlapping it otherwise are packed first
+     */
+    void sum(const BasicNPNumberView<const double>& a, const BasicNPNumberView<const double>& b) const {
+      linear(a, 1.0, b, 1.0);
+    }
+
+    void difference(const BasicNPNumberView<const double>& a, const BasicNPNumberView<const double>& b) const {
+      linear(a, 1.0, b, -1.0);
+    }
+
+    /**
+     * this = fa * a + fb * b
+     */
+    void linear(const BasicNPNumberView<const double>& a, double fa,
+		const BasicNPNumberView<const double>& b, double fb) const {
+      if (!fieldwise(a) || !fieldwise(b)) {
+	const std::vector<double> pa(packed(a));
+	const std::vector<double> pb(packed(b));
+	linear(BasicNPNumberView<const double>(pa.data(), _params, _order), fa,
+	       BasicNPNumberView<const double>(pb.data(), _params, _order), fb);
+	return;
+      }
+      for (unsigned int n = 0; n <= _order; ++n) {
+	const double* an = a.fields + n*a._stride;
+	const double* bn = b.fields + n*b._stride;
+	double* t = fields + n*_stride;
+	for (unsigned int j = 0; j <= _params; ++j)
+	  t[j] = fa * an[j] + fb * bn[j];
+      }
+    }
+
+    void sum(const BasicNPNumberView<const double>& a, double s) const {
+      assign(a);
+      fields[0] += s;
+    }
+
+    void scaled(const BasicNPNumberView<const double>& a, double f) const {
+      if (!fieldwise(a)) {
+	const std::vector<double> pa(packed(a));
+	scaled(BasicNPNumberView<const double>(pa.data(), _params, _order), f);
+	return;
+      }
+      for (unsigned int n = 0; n <= _order; ++n) {
+	const double* an = a.fields + n*a._stride;
+	double* t = fields + n*_stride;
+	for (unsigned int j = 0; j <= _params; ++j)
+	  t[j] = f * an[j];
+      }
+    }
+
+    /* the remaining operations may also write into an operand, overlapping buffers are packed first */
+    void product(const BasicNPNumberView<const double>& a, const BasicNPNumberView<const double>& b) const {
+      const Multiplication& m = Multiplication::ensureExistance(_order);
+      const bool aliasA = a.fields == fields;
+      const bool aliasB = b.fields == fields;
+
+      if (contiguous() && a.contiguous() && b.contiguous() &&
+	  (aliasA || !overlaps(a)) && (aliasB || !overlaps(b))) {
+	if (aliasA || aliasB)
+	  m.applyInPlace(a.fields, b.fields, fields, _params + 1);
+	else
+	  m.apply(a.fields, b.fields, fields, _params + 1);
+      } else if (a._stride == _stride && b._stride == _stride && !overlaps(a) && !overlaps(b)) {
+	m.applyStrided(a.fields, b.fields, fields, _params + 1, _stride);
+      } else {
+	const std::vector<double> pa(packed(a));
+	const std::vector<double> pb(packed(b));
+	std::vector<double> t(pa.size());
+	m.apply(pa.data(), pb.data(), t.data(), _params + 1);
+	unpack(t);
+      }
+    }
+
+    void pow(const BasicNPNumberView<const double>& a, int n, PowerMethod method = Power::method()) const {
+      Multiplication::ensureExistance(_order);
+      run(a, [n, method](const double* x, double* t, unsigned int order, unsigned int width) {
+	  Power::apply(n, x, t, order, width, method);
+	});
+    }
+
+    void pow(const BasicNPNumberView<const double>& a, double alpha) const {
+      run(a, [alpha](const double* x, double* t, unsigned int order, unsigned int width) {
+	  Elementary::pow(x, t, alpha, order, width);
+	});
+    }
+
+    /**
+     * this = a^b
+     */
+    void pow(const BasicNPNumberView<const double>& a, const BasicNPNumberView<const double>& b) const {
+      run(a, b, [](const double* x, const double* y, double* t, unsigned int order, unsigned int width) {
+	  Elementary::pow(x, y, t, order, width);
+	});
+    }
+
+    void atan2(const BasicNPNumberView<const double>& y, const BasicNPNumberView<const double>& x) const {
+      run(y, x, [](const double* a, const double* b, double* t, unsigned int order, unsigned int width) {
+	  Elementary::atan2(a, b, t, order, width);
+	});
+    }
+
+    void hypot(const BasicNPNumberView<const double>& x, const BasicNPNumberView<const double>& y) const {
+      run(x, y, [](const double* a, const double* b, double* t, unsigned int order, unsigned int width) {
+	  Elementary::hypot(a, b, t, order, width);
+	});
+    }
+
+    void sqrt(const BasicNPNumberView<const double>& a) const { run(a, &Elementary::sqrt); }
+
+    void cbrt(const BasicNPNumberView<const double>& a) const { run(a, &Elementary::cbrt); }
+
+    void exp(const BasicNPNumberView<const double>& a) const { run(a, &Elementary::exp); }
+
+    void log(const BasicNPNumberView<const double>& a) const { run(a, &Elementary::log); }
+
+    /**
+     * this = f(a) for a function given by its order+2 derivatives at the value of a
+     */
+    void compose(const double* f, const BasicNPNumberView<const double>& a) const {
+      const Composition* c = CompositionCache::staticGetInstance(_order);
+      run(a, [c, f](const double* x, double* t, unsigned int, unsigned int width) {
+	  c->apply(f, x, t, width);
+	});
+    }
+
+    void apply(const UnaryFunction& f, const BasicNPNumberView<const double>& a) const {
+      run(a, [&f](const double* x, double* t, unsigned int order, unsigned int width) {
+	  f.apply(x, t, order, width);
+	});
+    }
+
+    /**
+     * this = sin(a), cos = cos(a)
+     */
+    void sincos(const BasicNPNumberView<const double>& a, const BasicNPNumberView<double>& cos) const {
+      run(a, cos, &Elementary::sincos);
+    }
+
+    /**
+     * this = sinh(a), cosh = cosh(a)
+     */
+    void sinhcosh(const BasicNPNumberView<const double>& a, const BasicNPNumberView<double>& cosh) const {
+      run(a, cosh, &Elementary::sinhcosh);
+    }
+
+  private:
+    /**
+     * true if a is this view or disjoint from it, i.e. field by field updates of this never clobber unread fields of a
+     */
+    bool fieldwise(const BasicNPNumberView<const double>& a) const {
+      return (a.fields == fields && a._stride == _stride) || !overlaps(a);
+    }
+
+    static std::vector<double> packed(const BasicNPNumberView<const double>& a) {
+      std::vector<double> p((a._params + 1) * (a._order + 1));
+      a.copyTo(p.data());
+      return p;
+    }
+
+    void unpack(const std::vector<double>& p) const {
+      assign(BasicNPNumberView<const double>(p.data(), _params, _order));
+    }
+
+    /**
+     * runs a kernel target = k(a) directly on contiguous, disjoint buffers and on packed copies otherwise
+     */
+    template<class Kernel> void run(const BasicNPNumberView<const double>& a, Kernel k) const {
+      if (contiguous() && a.contiguous() && !overlaps(a)) {
+	k(a.fields, fields, _order, _params + 1);
+      } else {
+	const std::vector<double> pa(packed(a));
+	std::vector<double> t(pa.size());
+	k(pa.data(), t.data(), _order, _params + 1);
+	unpack(t);
+      }
+    }
+
+    /**
+     * run() for binary kernels target = k(a, b)
+     */
+    template<class Kernel> void run(const BasicNPNumberView<const double>& a, const BasicNPNumberView<const double>& b,
+				    Kernel k) const {
+      if (contiguous() && a.contiguous() && b.contiguous() && !overlaps(a) && !overlaps(b)) {
+	k(a.fields, b.fields, fields, _order, _params + 1);
+      } else {
+	const std::vector<double> pa(packed(a));
+	const std::vector<double> pb(packed(b));
+	std::vector<double> t(pa.size());
+	k(pa.data(), pb.data(), t.data(), _order, _params + 1);
+	unpack(t);
+      }
+    }
+
+    /**
+     * run() for kernels with two results, this and second = k(a)
+     */
+    template<class Kernel> void run(const BasicNPNumberView<const double>& a, const BasicNPNumberView<double>& second,
+				    Kernel k) const {
+      if (contiguous() && a.contiguous() && second.contiguous() &&
+	  !overlaps(a) && !second.overlaps(a) && !overlaps(second)) {
+	k(a.fields, fields, second.fields, _order, _params + 1);
+      } else {
+	const std::vector<double> pa(packed(a));
+	std::vector<double> t(pa.size());
+	std::vector<double> s(pa.size());
+	k(pa.data(), t.data(), s.data(), _order, _params + 1);
+	unpack(t);
+	second.unpack(s);
+      }
+    }
+
+  };
+
+  typedef BasicNPNumberView<double> NPNumberView;
+  typedef BasicNPNumberView<const double> ConstNPNumberView;
+}
+
+#endif
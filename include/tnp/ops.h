@@ -25,11 +25,83 @@ extern "C" {
 #endif
 
   #include <stddef.h>
+  #include <tnp/context.h>
+
+  /*
+   * Every computing function has a *_ctx variant taking the tnp_context to evaluate in,
+   * the plain function uses the default context of the calling thread. The linear operations
+   * (add, dadd, dmult, sub, dsub) need neither tables nor scratch memory and have no variant.
+   */
 
   void op_prepare(int order);
+
+  /**
+   * returns f^(k)(x) of a user defined function
+   */
+  typedef double (*tnp_derivative_callback)(double x, int k, void* data);
+
+  /**
+   * writes f(x), f'(x), ..., f^(n)(x) of a user defined function into f
+   */
+  typedef void (*tnp_derivatives_callback)(double x, int n, double* f, void* data);
+
+  /**
+   * registers a user defined function and returns its id, either callback may be NULL,
+   * but not both (-1 is returned then). The callbacks may be invoked concurrently from
+   * several threads, e.g. the workers of a parallel tape evaluation, with the same data.
+   */
+  int tnp_function_register(tnp_derivative_callback scalar, tnp_derivatives_callback batch, void* data);
   
   size_t tnp_number_payload_size(int params, int order);
   
+  /*
+   * The padded layout: row n of a number starts at n * tnp_number_padded_stride(params), a multiple 
+   * of the vector width the library is compiled for. Buffers allocated 64-byte aligned 
+   * (e.g. with aligned_alloc) start every row on a vector boundary.
+   */
+  int tnp_number_padded_stride(int params);
+
+  size_t tnp_number_padded_payload_size(int params, int order);
+
+  /**
+   * copies a packed number into a padded buffer and zeroes the padding
+   */
+  void op_tnp_number_pad(int params, int order, double* padded, double* packed);
+
+  /**
+   * copies a padded number into a packed buffer
+   */
+  void op_tnp_number_unpad(int params, int order, double* packed, double* padded);
+
+  /**
+   * target = a * b on padded buffers, target must not overlap a or b
+   */
+  void op_tnp_number_mult_padded(int params, int order, double* target, double* a, double* b);
+
+  void op_tnp_number_mult_padded_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* b);
+
+  /*
+   * The parameter-major layout: the derivatives of order 0 .. order of parameter j 
+   * (0 for the total derivatives) are stored contiguously at j * (order+1).
+   */
+
+  /**
+   * transposes a number into the parameter-major layout, target must not overlap a
+   */
+  void op_tnp_number_to_parameter_major(int params, int order, double* target, double* a);
+
+  /**
+   * transposes a parameter-major number back into the packed layout, target must not overlap a
+   */
+  void op_tnp_number_to_order_major(int params, int order, double* target, double* a);
+
+  /**
+   * target = a * b on parameter-major buffers, target must not overlap a or b
+   */
+  void op_tnp_number_mult_parameter_major(int params, int order, double* target, double* a, double* b);
+
+  void op_tnp_number_mult_parameter_major_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* b);
+
   void op_tnp_number_to_zero(int params, int order, double* a);
 
   void op_tnp_number_write_variable(int params, int order, double* a, double val, int n);
@@ -48,11 +120,14 @@ extern "C" {
 
   void op_tnp_number_mult(int params, int order, double* target, double* a, double* b);
 
+  void op_tnp_number_mult_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* b);
+
   void op_tnp_number_dmult(int params, int order, double* target, double* a, double b);
 
   void op_tnp_number_sub(int params, int order, double* target, double* a, double* b);
 
   void op_tnp_number_dsub(int params, int order, double* target, double* a, double b);
+
   /*
     double* double_div(int params, int order, double* a, double* b);
 
@@ -60,6 +135,70 @@ extern "C" {
   */
   void op_tnp_number_pow(int params, int order, double* target, double* a, int power);
 
+  void op_tnp_number_pow_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, int n);
+
+  /**
+   * overrides the algorithm of all integer powers: 
+   * 0 = automatic (default), 1 = repeated squaring, 2 = recurrence, 3 = composition,
+   * other values are ignored
+   */
+  void op_pow_method(int method);
+
+  void op_tnp_number_powr(int params, int order, double* target, double* a, double power);
+
+  void op_tnp_number_powr_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double power);
+
+  void op_tnp_number_npow(int params, int order, double* target, double* a, double* b);
+
+  void op_tnp_number_npow_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* b);
+
+  void op_tnp_number_atan2(int params, int order, double* target, double* y, double* x);
+
+  void op_tnp_number_atan2_ctx(struct tnp_context* ctx, int params, int order, double* target, double* y, double* x);
+
+  void op_tnp_number_hypot(int params, int order, double* target, double* x, double* y);
+
+  void op_tnp_number_hypot_ctx(struct tnp_context* ctx, int params, int order, double* target, double* x, double* y);
+
+  void op_tnp_number_sqrt(int params, int order, double* target, double* a);
+
+  void op_tnp_number_sqrt_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a);
+
+  void op_tnp_number_cbrt(int params, int order, double* target, double* a);
+
+  void op_tnp_number_cbrt_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a);
+
+  /**
+   * applies a registered function, an unknown id fills target with NaN
+   */
+  void op_tnp_number_apply(int params, int order, double* target, double* a, int function);
+
+  void op_tnp_number_apply_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, int function);
+
+  /**
+   * applies m functions given by their order+2 derivatives (stored one after another in f) 
+   * to a, the m results are stored one after another in target
+   */
+  void op_tnp_number_compose_many(int params, int order, double* target, double* a, double* f, int m);
+
+  void op_tnp_number_compose_many_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* f, int m);
+
+  void op_tnp_number_exp(int params, int order, double* target, double* a);
+
+  void op_tnp_number_exp_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a);
+
+  void op_tnp_number_log(int params, int order, double* target, double* a);
+
+  void op_tnp_number_log_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a);
+
+  void op_tnp_number_sincos(int params, int order, double* sin, double* cos, double* a);
+
+  void op_tnp_number_sincos_ctx(struct tnp_context* ctx, int params, int order, double* sin, double* cos, double* a);
+
+  void op_tnp_number_sinhcosh(int params, int order, double* sinh, double* cosh, double* a);
+
+  void op_tnp_number_sinhcosh_ctx(struct tnp_context* ctx, int params, int order, double* sinh, double* cosh, double* a);
+
 #ifdef __cplusplus
 }
 #endif
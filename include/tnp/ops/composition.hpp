@@ -24,6 +24,7 @@
 
 #include <boost/ptr_container/ptr_vector.hpp>
 
+#include <tnp/ordertable.hpp>
 #include <tnp/ops/multiplication.hpp>
 #include <tnp/polynomial.hpp>
 #include <boost/math/special_functions/factorials.hpp>
@@ -50,6 +51,10 @@ namespace tnp {
       const vector<DerSumOfProducts> der_bell_polynomials;
       const Composition* last;
 
+      /* multiplications needed for the value and for each partial derivative, up to this order */
+      const double valueCost;
+      const double derCost;
+
       const StdPolynomial& convolute(unsigned int n, unsigned int k);
       const StdPolynomial& getConvolute(unsigned int k);
       const StdPolynomial makeConvolute(unsigned int k);
@@ -58,15 +63,54 @@ namespace tnp {
 
       vector<DerSumOfProducts> compileDerPolynomials(const unsigned int order);
 
+      double compileValueCost() const;
+
+      double compileDerCost() const;
+
+      void applyMany(const double* f, unsigned int fStride, unsigned int m, const double* a,
+		     double* target, unsigned int targetStride, unsigned int width) const;
+
+      void applyBell(const double* f, const double* a,
+		     double* target, unsigned int width) const;
+
+      void applyAffine(const double* f, const double* a,
+		       double* target, unsigned int width) const;
+
+      void applyBellTransposed(const double* f, const double* a, double* target,
+			       unsigned int width, unsigned int length) const;
+
+      void applyAffineTransposed(const double* f, const double* a,
+				 double* target, unsigned int width) const;
+
     public:
       const vector<SumOfProducts>& bell() const { return bell_polynomials; }
 
+      typedef void (Composition::*Kernel)(const double* f, const double* a, double* target) const;
+
+      /**
+       * applyBell() for a width fixed at compile time, the derivative Bell polynomials 
+       * are evaluated for all parameter columns at once
+       */
+      template<unsigned int W> void applyBellFixed(const double* f, const double* a, double* target) const;
+
+      /**
+       * the fixed-width kernel for width, NULL if there is none
+       */
+      static Kernel fixedKernel(unsigned int width);
+
+      /**
+       * number of multiplications apply() needs for the given width
+       */
+      double cost(unsigned int width) const { return valueCost + (width - 1) * derCost; }
+
       Composition(Composition* smaller) : order(smaller->order+1),
 					  binomial(Multiplication::compileBinomial(smaller->order+1)), 
 					  bell_polynomials(compilePolynomials(smaller->order+1)), 
-					  der_bell_polynomials(compileDerPolynomials(smaller->order+1)), last(smaller)  {}
+					  der_bell_polynomials(compileDerPolynomials(smaller->order+1)), last(smaller),
+					  valueCost(compileValueCost()), derCost(compileDerCost()) {}
 
-      Composition() : order(0), binomial(Multiplication::compileBinomial(0)), last(NULL) {}
+      Composition() : order(0), binomial(Multiplication::compileBinomial(0)), last(NULL),
+		      valueCost(0), derCost(1) {}
       
       void apply(const vector<double>& a, const vector<double>& b,
 		 vector<double>& target, unsigned int width) const;
@@ -74,36 +118,74 @@ namespace tnp {
       void apply(const double* f, const double* b,
 		 double* target, unsigned int width) const;
 
+      /**
+       * apply() with a known degree of the argument in t, i.e. the highest order
+       * with a non-zero field. Arguments of degree <= 1 skip the Bell polynomials,
+       * widths up to FIXED_MAX_PARAMS + 1 run a fixed-width kernel.
+       */
+      void apply(const double* f, const double* b,
+		 double* target, unsigned int width, unsigned int degree) const;
+
+      /**
+       * apply() in the parameter-major layout (see Layout): the Bell polynomials read 
+       * the contiguous series of the total derivatives and of one parameter at a time.
+       * Sums the same terms in the same order as apply().
+       */
+      void applyTransposed(const double* f, const double* a,
+			   double* target, unsigned int width) const;
+
+      /**
+       * apply() for fields of any scalar type T, with the derivatives f and the Bell sums in Acc.
+       * Instantiated like Multiplication::applyScalar().
+       */
+      template<class T, class Acc>
+      void applyScalar(const Acc* f, const T* a, T* target, unsigned int width) const;
+
+      /**
+       * the highest order with a non-zero total or partial derivative
+       */
+      static unsigned int degree(const double* a, unsigned int order, unsigned int width);
+
+      /**
+       * Applies m functions to the same argument, evaluating the Bell polynomials only once.
+       * f holds the m derivative vectors (order+2 fields each) one after another, 
+       * the results are written to target one after another ((order+1)*width fields each).
+       */
+      void applyMany(const double* f, unsigned int m, const double* a,
+		     double* target, unsigned int width) const;
+
     };
 
+    /**
+     * The compositions of all orders, built on demand from the one below.
+     * Lookups of built orders take no lock, so any thread may call staticGetInstance().
+     */
     class CompositionCache {
       
       static CompositionCache instance;
 
-      vector<Composition*> cache;
-    public:
-      CompositionCache() {
-	cache.push_back(new Composition());       
+      OrderTable<Composition*> cache;
+
+      Composition* make(unsigned int order) {
+	return order == 0 ? new Composition() : new Composition(cache[order - 1]);
       }
+
+    public:
+      CompositionCache() : cache(0, [this](unsigned int n) { return make(n); }) {}
       
       ~CompositionCache() {
-	for (Composition* c : cache)
-	  delete c;
+	for (unsigned int n = 0; n < cache.size(); ++n)
+	  delete cache[n];
       }
 
-      inline static Composition* staticGetInstance(int order) {
+      inline static Composition* staticGetInstance(unsigned int order) {
 	return instance.getInstance(order);
       };
 
-      Composition* getInstance(int order) {
-	if (cache.size() > order)
-	  return cache[order];
-	else {
-	  while(cache.size() <= order)
-	    cache.push_back(new Composition(cache.back()));
-	  
-	  return cache.back();
-	}	  
+      Composition* getInstance(unsigned int order) {
+	if (order >= cache.size())
+	  cache.grow(order, [this](unsigned int n) { return make(n); });
+	return cache[order];
       };
     };
   }
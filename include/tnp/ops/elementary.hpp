@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_OPS_ELEMENTARY_HPP
+#define TNP_OPS_ELEMENTARY_HPP 1
+
+#include <vector>
+
+#include <tnp/ops/multiplication.hpp>
+
+namespace tnp {
+  namespace ops {
+    using namespace std;
+
+    /**
+     * Elementary functions evaluated by their Taylor recurrences instead of the
+     * Bell polynomials of Composition. Each kernel costs O(order^2 * width) and
+     * computes the parameter columns in the same sweep as the total derivatives.
+     * Arguments that are polynomials of low degree in t (e.g. free variables)
+     * shrink the row sums to O(degree * width).
+     * The target must not alias the argument.
+     * The binary functions take optional scratch memory of scratchSize() fields,
+     * without it they allocate their intermediates.
+     */
+    class Elementary {
+      /**
+       * t^(n) += factor * (y * x')^(n-1) = factor * \sum_k \binom{n-1}{k} y^(k) x^(n-k)
+       * only the terms with x^(n-k) up to the given degree of x are summed
+       */
+      static void accumulateRow(const double* y, const double* x, double* t, double factor,
+				unsigned int n, unsigned int width, unsigned int degree);
+
+      /**
+       * resolves (r * y')^(n-1) = rhs for y^(n), where rhs is expected in the n-th row of y
+       * only the terms with r^(k) up to the given degree of r are summed
+       */
+      static void quotientRow(const double* r, double* y, unsigned int n, unsigned int width,
+			      unsigned int degree);
+
+      /**
+       * s' = c * x', c' = sign * s * x', evaluated in one sweep
+       */
+      static void coupled(const double* a, double* s, double* c, double sign,
+			  unsigned int order, unsigned int width);
+
+      /**
+       * x * y' = alpha * y * x', expects y = x^alpha to be set in target[0]
+       */
+      static void power(const double* a, double* target, double alpha,
+			unsigned int order, unsigned int width);
+
+    public:
+      static unsigned int scratchSize(unsigned int order, unsigned int width) {
+	return 2 * width * (order + 1);
+      }
+
+      /**
+       * y = exp(x), from y' = y * x'
+       */
+      static void exp(const double* a, double* target, unsigned int order, unsigned int width);
+
+      /**
+       * y = log(x), from x * y' = x'
+       */
+      static void log(const double* a, double* target, unsigned int order, unsigned int width);
+
+      /**
+       * s = sin(x), c = cos(x), from s' = c * x' and c' = -s * x'
+       */
+      static void sincos(const double* a, double* s, double* c, unsigned int order, unsigned int width);
+
+      /**
+       * s = sinh(x), c = cosh(x), from s' = c * x' and c' = s * x'
+       */
+      static void sinhcosh(const double* a, double* s, double* c, unsigned int order, unsigned int width);
+
+      /**
+       * y = x^alpha for any real alpha, from x * y' = alpha * y * x'
+       * The value of x must not be zero.
+       */
+      static void pow(const double* a, double* target, double alpha, unsigned int order, unsigned int width);
+
+      /**
+       * y = sqrt(x), the value of x must be positive
+       */
+      static void sqrt(const double* a, double* target, unsigned int order, unsigned int width);
+
+      /**
+       * y = cbrt(x), the value of x must not be zero
+       */
+      static void cbrt(const double* a, double* target, unsigned int order, unsigned int width);
+
+      /**
+       * z = x^y for two numbers of the same shape, the value of x must be positive
+       */
+      static void pow(const double* a, const double* b, double* target, unsigned int order, unsigned int width,
+		      double* scratch = nullptr);
+
+      /**
+       * z = atan2(y, x), from (x^2 + y^2) * z' = x * y' - y * x'
+       */
+      static void atan2(const double* y, const double* x, double* target, unsigned int order, unsigned int width,
+			double* scratch = nullptr);
+
+      /**
+       * z = sqrt(x^2 + y^2), from z * z' = (x^2 + y^2)' / 2
+       */
+      static void hypot(const double* x, const double* y, double* target, unsigned int order, unsigned int width,
+			double* scratch = nullptr);
+    };
+  }
+}
+#endif
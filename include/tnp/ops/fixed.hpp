@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_OPS_FIXED_HPP
+#define TNP_OPS_FIXED_HPP 1
+
+#include <array>
+#include <vector>
+#include <atomic>
+
+#include <tnp/ops/multiplication.hpp>
+
+namespace tnp {
+  namespace ops {
+
+    /**
+     * Multiplication::apply and Composition::apply dispatch shapes up to these bounds
+     * to kernels instantiated for the shape, larger ones run the generic loops
+     */
+    const unsigned int FIXED_MAX_ORDER = 6;
+    const unsigned int FIXED_MAX_PARAMS = 16;
+
+    class FixedKernels {
+    public:
+      /**
+       * switches the dispatch on (default) or off, e.g. for benchmarks,
+       * also while other threads multiply
+       */
+      static std::atomic<bool>& enabled() {
+	static std::atomic<bool> e(true);
+	return e;
+      }
+    };
+
+    /**
+     * Multiplication for a shape known at compile time. All loop bounds are constants,
+     * so the compiler can unroll the row sums and vectorize over the parameter columns.
+     * Sums the same terms in the same order as Multiplication::applyGeneric().
+     */
+    template<unsigned int P, unsigned int O> class FixedMultiplication {
+      static const unsigned int width = P + 1;
+
+      typedef std::array<std::array<double, O + 1>, O + 1> Binomials;
+
+      static Binomials compileBinomials() {
+	Binomials b;
+	for (unsigned int n = 0; n <= O; ++n) {
+	  const vector<double> row = Multiplication::compileBinomial(n);
+	  for (unsigned int k = 0; k <= O; ++k)
+	    b[n][k] = k <= n ? row[k] : 0.0;
+	}
+	return b;
+      }
+
+    public:
+      /**
+       * \binom{n}{k} for all n, k <= O
+       */
+      static const Binomials& binomials() {
+	static const Binomials b(compileBinomials());
+	return b;
+      }
+
+      /**
+       * target = a * b, the target must not alias a or b
+       */
+      static void apply(const double* a, const double* b, double* target) {
+	const Binomials& binomial = binomials();
+
+	for (unsigned int n = 0; n <= O; ++n) {
+	  std::array<double, width> d;
+	  d.fill(0.0);
+
+	  for (unsigned int k = 0; k <= n; ++k) {
+	    const double c = binomial[n][k];
+	    const double* ak = a + (n - k)*width;
+	    const double* bk = b + k*width;
+
+	    d[0] += c * ak[0] * bk[0];
+	    for (unsigned int j = 1; j < width; ++j) {
+	      d[j] += c * ak[j] * bk[0];
+	      d[j] += c * ak[0] * bk[j];
+	    }
+	  }
+
+	  for (unsigned int j = 0; j < width; ++j)
+	    target[n*width + j] = d[j];
+	}
+      }
+    };
+  }
+}
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_OPS_FUNCTIONS_HPP
+#define TNP_OPS_FUNCTIONS_HPP 1
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+
+namespace tnp {
+  namespace ops {
+    using namespace std;
+
+    /**
+     * returns f^(k)(x)
+     */
+    typedef std::function<double(double x, unsigned int k)> DerivativeGenerator;
+
+    /**
+     * writes f(x), f'(x), ..., f^(n)(x) into the n+1 fields of f
+     */
+    typedef std::function<void(double x, unsigned int n, double* f)> BatchDerivativeGenerator;
+
+    /**
+     * A user defined scalar function, applied to np-numbers via Composition
+     */
+    class UnaryFunction {
+      DerivativeGenerator scalar;
+      BatchDerivativeGenerator batch;
+
+    public:
+      const unsigned int id;
+
+      UnaryFunction(unsigned int id, DerivativeGenerator s, BatchDerivativeGenerator b) :
+	scalar(s), batch(b), id(id) {}
+
+      /**
+       * writes the first n derivatives at x into f, preferring the batched generator
+       */
+      void derivatives(double x, unsigned int n, double* f) const;
+
+      /**
+       * target = f(a), f holds order+2 fields of scratch memory for the derivatives,
+       * without it they are allocated
+       */
+      void apply(const double* a, double* target, unsigned int order, unsigned int width,
+		 double* f = nullptr) const;
+    };
+
+    /**
+     * Registry of all user defined functions, a function is identified by the id returned from add().
+     * Entries are never moved, so references from get() stay valid while functions are added
+     * from other threads.
+     */
+    class FunctionRegistry {
+      inline static deque<UnaryFunction>& functions() {
+	static deque<UnaryFunction> registry;
+	return registry;
+      }
+
+      inline static mutex& lock() {
+	static mutex m;
+	return m;
+      }
+
+    public:
+      /**
+       * the id add() returns for a function without generators
+       */
+      static const unsigned int INVALID = ~0u;
+
+      /**
+       * registers a function given by its derivatives, at least one of the generators must be set
+       */
+      static unsigned int add(DerivativeGenerator scalar, BatchDerivativeGenerator batch = nullptr);
+
+      /**
+       * true if id was returned by add()
+       */
+      static bool valid(unsigned int id) { return id < size(); }
+
+      /**
+       * the function of a valid id
+       */
+      static const UnaryFunction& get(unsigned int id) {
+	lock_guard<mutex> l(lock());
+	return functions()[id];
+      }
+
+      static unsigned int size() {
+	lock_guard<mutex> l(lock());
+	return functions().size();
+      }
+    };
+  }
+}
+#endif
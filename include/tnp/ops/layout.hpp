@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_OPS_LAYOUT_HPP
+#define TNP_OPS_LAYOUT_HPP 1
+
+namespace tnp {
+  namespace ops {
+
+    /**
+     * Conversions between the two layouts of the fields of a number:
+     * order-major (the layout of NPNumber), a[n*width + j], every row holds one order
+     * of the value and all partial derivatives, and
+     * parameter-major, a[j*(order+1) + n], every column holds the whole series of one parameter
+     * (column 0 the total derivatives), e.g. for integrators working on one series at a time.
+     */
+    class Layout {
+    public:
+      /**
+       * side of the square tiles of the transpose, 8x8 doubles keep the source rows 
+       * and the destination rows of a tile within L1
+       */
+      static const unsigned int TRANSPOSE_BLOCK = 8;
+
+      /**
+       * dst[c*rows + r] = src[r*cols + c], tile by tile. src and dst must not overlap.
+       */
+      static void transpose(const double* src, double* dst, unsigned int rows, unsigned int cols);
+
+      static void toParameterMajor(const double* a, double* target, unsigned int order, unsigned int width) {
+	transpose(a, target, order + 1, width);
+      }
+
+      static void toOrderMajor(const double* a, double* target, unsigned int order, unsigned int width) {
+	transpose(a, target, width, order + 1);
+      }
+    };
+  }
+}
+#endif
@@ -22,6 +22,8 @@
 #include <vector>
 #include <tuple>
 
+#include <tnp/ordertable.hpp>
+
 namespace tnp {
 
   using namespace std;
@@ -41,18 +43,33 @@ namespace tnp {
     void evalValue(const double* a, const double* b,
 		   double* target, const unsigned int width) const;
 
+    /**
+     * the rows of applyPadded() and applyStrided(), writing the first columns fields of each row
+     */
+    void applyRows(const double* a, const double* b, double* target,
+		   unsigned int columns, unsigned int stride) const;
+
   public:
+    typedef void (*Kernel)(const double* a, const double* b, double* target);
+
+    /**
+     * the fixed-shape kernel for (order, width), NULL if there is none
+     */
+    static Kernel fixedKernel(unsigned int order, unsigned int width);
     
     /*
      * Compiles a vector containing all binomials \frac{k}{n} \forall k \in 1 \ldots n
      */
     static vector<double> compileBinomial(const unsigned int order);
 
+    static Multiplication make(unsigned int order) { return Multiplication(order); }
+
     /**
-     * return the cacheVector without initialisation
+     * return the cacheVector without initialisation. Entries never move, orders below its size
+     * can be read while other threads grow it.
      */
-    inline static vector<Multiplication>& cacheVector() {
-      static vector<Multiplication> cache({Multiplication(0)});
+    inline static OrderTable<Multiplication>& cacheVector() {
+      static OrderTable<Multiplication> cache(0, &make);
 
       return cache;
     }
@@ -60,7 +77,7 @@ namespace tnp {
     /**
      * Gets the cache vector and ensures that it is filled up to the given order
      */
-    static vector<Multiplication>& cacheVectorInitialized(const unsigned int upTo);
+    static OrderTable<Multiplication>& cacheVectorInitialized(const unsigned int upTo);
 
     static Multiplication& ensureExistance(const unsigned int order) {
       if (cacheVector().size() <= order) {
@@ -69,15 +86,81 @@ namespace tnp {
       return cacheVector()[order];
     }
         
+    /**
+     * the binomials \binom{order}{k} this multiplication is based upon
+     */
+    inline const vector<double>& binomials() const { return binomial; }
+
     Multiplication(unsigned int o) : order(o), //valueSum(compileValueSum(o)), partialDerSum(compileDerSum(o)), 
 				     binomial(compileBinomial(o)) {}
 
     void apply(const vector<double>& a, const vector<double>& b,
 	       vector<double>& target, unsigned int width) const;
 
+    /**
+     * target = a * b, shapes within FIXED_MAX_ORDER and FIXED_MAX_PARAMS run a fixed-shape kernel
+     */
     void apply(const double* a, const double* b,
 	       double* target, unsigned int width) const;
 
+    /**
+     * apply() with the generic loops only
+     */
+    void applyGeneric(const double* a, const double* b,
+		      double* target, unsigned int width) const;
+
+    /**
+     * evaluates only the order-th row (value and partial derivatives) of the product
+     */
+    void applyRow(const double* a, const double* b,
+		  double* target, unsigned int width) const;
+
+    /**
+     * same as apply(), but target may alias a, b or both: 
+     * every field only reads the value and its own column of the same or lower rows, 
+     * so the rows are evaluated top down and the value of each row last
+     */
+    void applyInPlace(const double* a, const double* b,
+		      double* target, unsigned int width) const;
+
+    /**
+     * target = a * b for rows of stride >= width, e.g. rows padded to the vector width.
+     * Whole rows are processed as vectors, a padding field of the target only reads
+     * padding fields of a and b, so all three buffers must own their padding,
+     * including that of the last row. Sums the same terms in the same order as apply(),
+     * the target must not alias a or b.
+     */
+    void applyPadded(const double* a, const double* b, double* target,
+		     unsigned int width, unsigned int stride) const;
+
+    /**
+     * applyPadded() for rows of stride >= width in buffers that do not own the gaps between
+     * the rows, e.g. views: only the width fields of each row are read and written.
+     */
+    void applyStrided(const double* a, const double* b, double* target,
+		      unsigned int width, unsigned int stride) const;
+
+    /**
+     * target = a * b in the parameter-major layout (see Layout), column by column:
+     * every partial derivative series only reads its own series and the total derivatives.
+     * Sums the same terms in the same order as apply(), the target must not alias a or b.
+     */
+    void applyTransposed(const double* a, const double* b, double* target, unsigned int width) const;
+
+    /**
+     * target = a * b for fields of any scalar type T, the row sums are accumulated in Acc,
+     * e.g. float fields with double sums. Instantiated for float, double and long double
+     * and for float with double accumulation. 
+     */
+    template<class T, class Acc>
+    void applyScalar(const T* a, const T* b, T* target, unsigned int width) const;
+
+    /**
+     * target += factor * (a * b), summing the same terms as apply()
+     */
+    void accumulate(const double* a, const double* b, double* target,
+		    double factor, unsigned int width) const;
+
   };
 }
 #endif
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_OPS_POWER_HPP
+#define TNP_OPS_POWER_HPP 1
+
+#include <atomic>
+
+namespace tnp {
+  namespace ops {
+
+    /**
+     * Algorithms for integer powers, POW_AUTOMATIC picks the cheapest applicable one
+     */
+    enum PowerMethod { POW_AUTOMATIC, POW_SQUARING, POW_RECURRENCE, POW_COMPOSITION };
+
+    /**
+     * Integer powers with a cost model over (exponent, order, params)
+     */
+    class Power {
+      static void squaring(int n, const double* a, double* target, unsigned int order, unsigned int width,
+			   double* scratch);
+
+      static void composition(int n, const double* a, double* target, unsigned int order, unsigned int width,
+			      unsigned int degree, double* scratch);
+
+    public:
+      /**
+       * the method used when none is given explicitly, POW_AUTOMATIC by default.
+       * It may be set while other threads compute powers.
+       */
+      static std::atomic<PowerMethod>& method() {
+	static std::atomic<PowerMethod> m(POW_AUTOMATIC);
+	return m;
+      }
+
+      /* estimated run time of each method, in roughly nanoseconds, for an argument of the given degree in t */
+      static double squaringCost(int n, unsigned int order, unsigned int width);
+
+      static double recurrenceCost(unsigned int order, unsigned int width, unsigned int degree);
+
+      static double compositionCost(unsigned int order, unsigned int width, unsigned int degree);
+
+      /**
+       * the cheapest method that is applicable to a^n:
+       * squaring needs n >= 2, the recurrence needs a != 0, composition always works
+       */
+      static PowerMethod choose(int n, const double* a, unsigned int order, unsigned int width);
+
+      /**
+       * fields of scratch memory apply() may use
+       */
+      static unsigned int scratchSize(unsigned int order, unsigned int width) {
+	return 2 * width * (order + 1);
+      }
+
+      /**
+       * target = a^n, a method that is not applicable falls back to POW_AUTOMATIC.
+       * Squaring and composition allocate their intermediates unless scratch is given.
+       */
+      static void apply(int n, const double* a, double* target, unsigned int order, unsigned int width,
+			PowerMethod m = POW_AUTOMATIC, double* scratch = nullptr);
+    };
+  }
+}
+#endif
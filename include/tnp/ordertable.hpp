@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_ORDER_TABLE_HPP
+#define TNP_ORDER_TABLE_HPP 1
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <algorithm>
+
+namespace tnp {
+
+  /**
+   * The per-order tables shared by all threads (Multiplication, Composition).
+   * Entries never move once built: they live in chunks of doubling size, the first one
+   * holding FIRST_CHUNK orders. Growing takes a lock, reading an order below size() does not,
+   * so a thread may use the orders it has seen while another one grows the table.
+   */
+  template<class T> class OrderTable {
+    static const unsigned int FIRST_CHUNK = 64;
+    static const unsigned int CHUNKS = 26;
+
+    T* chunks[CHUNKS];
+    std::atomic<unsigned int> count;
+    std::mutex lock;
+
+    /**
+     * the chunk of an order, order becomes its index in the chunk
+     */
+    static inline unsigned int locate(unsigned int& order) {
+      unsigned int c = 0;
+      unsigned int n = FIRST_CHUNK;
+      while (order >= n) {
+	order -= n;
+	n *= 2;
+	++c;
+      }
+      return c;
+    }
+
+  public:
+    OrderTable() : count(0) {
+      std::fill(chunks, chunks + CHUNKS, (T*) 0);
+    }
+
+    template<class Make> OrderTable(unsigned int upTo, Make make) : OrderTable() {
+      grow(upTo, make);
+    }
+
+    ~OrderTable() {
+      const unsigned int n = count.load();
+      for (unsigned int i = 0; i < n; ++i)
+	(*this)[i].~T();
+      for (T* c : chunks)
+	::operator delete(c);
+    }
+
+    OrderTable(const OrderTable&) = delete;
+    OrderTable& operator=(const OrderTable&) = delete;
+
+    /**
+     * the number of built orders
+     */
+    inline unsigned int size() const { return count.load(std::memory_order_acquire); }
+
+    inline T& operator[](unsigned int order) const {
+      const unsigned int c = locate(order);
+      return chunks[c][order];
+    }
+
+    /**
+     * builds all orders up to upTo with make(order), which may read the lower orders
+     */
+    template<class Make> void grow(unsigned int upTo, Make make) {
+      std::lock_guard<std::mutex> guard(lock);
+      for (unsigned int order = count.load(std::memory_order_relaxed); order <= upTo; ++order) {
+	unsigned int i = order;
+	const unsigned int c = locate(i);
+	if (!chunks[c])
+	  chunks[c] = static_cast<T*>(::operator new(sizeof(T) * (FIRST_CHUNK << c)));
+	new (chunks[c] + i) T(make(order));
+	count.store(order + 1, std::memory_order_release);
+      }
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_PARALLEL_TAPE_HPP
+#define TNP_PARALLEL_TAPE_HPP 1
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+#include <tnp/tape.hpp>
+
+namespace tnp {
+
+  /**
+   * Replays a tape like TapeEvaluator, running independent instructions concurrently.
+   * The instructions form a DAG by the slots they read and write (a slot is only written
+   * once all earlier readers are done, so tapes after TapeOptimizer::allocateSlots() work, too).
+   * Every instruction is weighted with an estimate of its multiplications, its priority is
+   * the heaviest path from it to the end of the tape, so the critical path starts first.
+   *
+   * By default each thread keeps a queue of ready instructions by priority, runs its most
+   * urgent one and steals the most urgent one of another thread when its own queue is empty.
+   * In the deterministic mode the instructions are assigned to the threads once, by a list
+   * schedule on the estimates, and every run executes the same instructions on the same thread
+   * in the same order. Each instruction computes the same fields in either mode and on any
+   * number of threads, so the results are those of TapeEvaluator.
+   *
+   * The calling thread takes part in run(), the other threads wait between runs.
+   * Registered functions (TAPE_APPLY) are called from the worker threads, possibly for several
+   * instructions at once, so their generators and C callbacks must be safe to call concurrently.
+   */
+  class ParallelTapeEvaluator {
+    struct Queue {
+      std::mutex lock;
+      /* a heap of ready instructions by priority */
+      std::vector<unsigned int> ready;
+      std::vector<double> scratch;
+    };
+
+    const Tape tape;
+    const unsigned int width;
+    const unsigned int size;
+    const bool _deterministic;
+    std::vector<double> arena;
+
+    /* the DAG */
+    std::vector<std::vector<unsigned int> > successors;
+    std::vector<std::vector<unsigned int> > predecessors;
+    std::vector<double> costs;
+    std::vector<double> priorities;
+    double _work;
+    double _criticalPath;
+
+    /* the instructions of each thread in the deterministic mode */
+    std::vector<std::vector<unsigned int> > assigned;
+
+    /* the state of a run */
+    std::unique_ptr<std::atomic<unsigned int>[]> pending;
+    std::unique_ptr<std::atomic<bool>[]> done;
+    std::atomic<unsigned int> remaining;
+    std::atomic<unsigned long> _steals;
+    std::deque<Queue> queues;
+
+    /* the pool */
+    std::vector<std::thread> pool;
+    std::mutex poolLock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    unsigned long generation;
+    unsigned int busy;
+    bool stop;
+
+    inline double* slot(unsigned int s) { return arena.data() + s*size; }
+
+    void buildGraph();
+    void scheduleStatically();
+
+    bool higher(unsigned int a, unsigned int b) const;
+    void push(unsigned int worker, unsigned int instruction);
+    bool pop(unsigned int worker, unsigned int& instruction);
+    bool steal(unsigned int worker, unsigned int& instruction);
+
+    void work(unsigned int worker);
+    void loop(unsigned int worker);
+
+  public:
+    /**
+     * threads = 0 uses one thread per hardware thread
+     */
+    explicit ParallelTapeEvaluator(const Tape& tape, unsigned int threads = 0, bool deterministic = false);
+
+    ~ParallelTapeEvaluator();
+
+    unsigned int threads() const { return queues.size(); }
+
+    bool deterministic() const { return _deterministic; }
+
+    /**
+     * the estimated multiplications of all instructions and of the heaviest path through them,
+     * work() / criticalPath() bounds the speedup of a run
+     */
+    double work() const { return _work; }
+    double criticalPath() const { return _criticalPath; }
+
+    /**
+     * the estimated multiplications of an instruction, at least 1
+     */
+    static double cost(const TapeInstruction& i, unsigned int order, unsigned int width);
+
+    /**
+     * instructions taken from the queue of another thread, over all runs
+     */
+    unsigned long steals() const { return _steals; }
+
+    NPNumberView input(unsigned int i) {
+      return NPNumberView(slot(tape.inputs()[i]), tape.params(), tape.order());
+    }
+
+    void seed(unsigned int i, double value) { slot(tape.inputs()[i])[0] = value; }
+
+    ConstNPNumberView output(unsigned int i) const {
+      return ConstNPNumberView(arena.data() + tape.outputs()[i]*size, tape.params(), tape.order());
+    }
+
+    void run();
+
+    /**
+     * as TapeEvaluator::operator(), no outputs if the tape does not accept the inputs
+     */
+    std::vector<NPNumber> operator()(const std::vector<NPNumber>& inputs);
+  };
+}
+
+#endif
@@ -21,10 +21,12 @@
 #define POLYNOMIAL_HPP 1
 
 #include <iostream>
+#include <vector>
 #include <boost/optional.hpp>
 #include <utility>
 #include <map>
 #include <set>
+#include <atomic>
 
 #include "prettyprint.hpp"
 
@@ -157,7 +159,10 @@ namespace tnp {
   class SumOfProducts {
   public:
     static long lookups;
-    static long evals;
+    /**
+     * products evaluated by all threads, counted once per sum
+     */
+    static std::atomic<long> evals;
     vector<Product> sum;
 
     SumOfProducts(const StdPolynomial& poly) {      
@@ -177,11 +182,15 @@ namespace tnp {
       }
     }
 
-    inline double eval(const double* arg, const int width) const {
-      double res = 0.0;
+    /**
+     * evaluates the sum for fields of type T, accumulating in Acc
+     */
+    template<class T, class Acc = T> 
+    inline Acc eval(const T* arg, const int width) const {
+      Acc res = 0.0;
+      evals.fetch_add(sum.size(), std::memory_order_relaxed);
       for (const Product& p : sum) {
-	evals++;
-	double prod = p.factor;
+	Acc prod = p.factor;
 	for (int f : p.fields) {
 	  prod *= arg[f*width];
 	}
@@ -235,11 +244,12 @@ namespace tnp {
       }
     }
 
-    inline double eval(const double* arg, const int width, const int der) const {
-      double res = 0.0;
+    template<class T, class Acc = T> 
+    inline Acc eval(const T* arg, const int width, const int der) const {
+      Acc res = 0.0;
+      SumOfProducts::evals.fetch_add(sum.size(), std::memory_order_relaxed);
       for (const DerProduct& p : sum) {
-	SumOfProducts::evals++;
-	double prod = p.factor;
+	Acc prod = p.factor;
 	for (DerProductField f : p.fields) {
 	  prod *= arg[f.key*width + (f.is_der ? der : 0)];
 	}
@@ -247,6 +257,24 @@ namespace tnp {
       }
       return res;
     };
+
+    /**
+     * eval() on the parameter-major layout, value holds the series of the total derivatives
+     * and der the series of the derived parameter
+     */
+    template<class T, class Acc = T> 
+    inline Acc evalSeries(const T* value, const T* der) const {
+      Acc res = 0.0;
+      SumOfProducts::evals.fetch_add(sum.size(), std::memory_order_relaxed);
+      for (const DerProduct& p : sum) {
+	Acc prod = p.factor;
+	for (DerProductField f : p.fields) {
+	  prod *= f.is_der ? der[f.key] : value[f.key];
+	}
+	res += prod;
+      }
+      return res;
+    };
   };
  
   /**
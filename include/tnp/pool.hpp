@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_POOL_HPP
+#define TNP_POOL_HPP 1
+
+#include <cstddef>
+#include <new>
+#include <atomic>
+
+namespace tnp {
+
+  /**
+   * A per-thread pool of memory blocks, sorted into size classes of CLASS_BYTES.
+   * Freed blocks are kept on a free list of their class and handed out again to the next request
+   * of that class, so a simulation creating numbers of the same shape over and over only
+   * reaches the system allocator for its first numbers. A block freed by another thread joins
+   * the pool of that thread. Requests above MAX_CLASS_BYTES go to the system allocator directly.
+   */
+  class Pool {
+  public:
+    static const std::size_t CLASS_BYTES = 64;
+    static const std::size_t MAX_CLASS_BYTES = 64 * 1024;
+    static const std::size_t CLASSES = MAX_CLASS_BYTES / CLASS_BYTES;
+
+    /**
+     * counters of the calling thread, e.g. for allocation benchmarks
+     */
+    struct Statistics {
+      std::size_t allocations;
+      std::size_t systemAllocations;
+      std::size_t deallocations;
+      std::size_t systemDeallocations;
+    };
+
+  private:
+    struct Block {
+      Block* next;
+    };
+
+    Block* freeLists[CLASSES];
+    Statistics ownStatistics;
+    /* the pool of a thread counts into storage that outlives it */
+    Statistics* stats;
+
+    explicit Pool(Statistics& counters);
+
+    static inline std::size_t sizeClass(std::size_t bytes) {
+      return (bytes + CLASS_BYTES - 1) / CLASS_BYTES;
+    }
+
+  public:
+    /**
+     * a pool of its own, e.g. for a tnp_context. Blocks of all pools come from the
+     * system allocator in the same size classes, so any pool can take back any block.
+     */
+    Pool();
+    ~Pool();
+
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    /**
+     * the pool of the calling thread
+     */
+    static Pool& local();
+
+    /**
+     * switches the reuse of freed blocks on (default) or off, e.g. for benchmarks.
+     * Blocks are always rounded to their size class, so the switch can be flipped at any time,
+     * also while other threads allocate.
+     */
+    static std::atomic<bool>& enabled() {
+      static std::atomic<bool> e(true);
+      return e;
+    }
+
+    void* allocate(std::size_t bytes);
+
+    /**
+     * returns a block, bytes must be the size it was allocated with
+     */
+    void deallocate(void* p, std::size_t bytes);
+
+    /**
+     * allocate() and deallocate() on the pool of the calling thread. Numbers destroyed
+     * after the pool of their thread (e.g. statics at exit) go to the system allocator.
+     */
+    static void* acquire(std::size_t bytes);
+
+    static void recycle(void* p, std::size_t bytes);
+
+    /**
+     * hands all cached blocks of this thread back to the system allocator
+     */
+    void release();
+
+    const Statistics& statistics() const { return *stats; }
+  };
+
+  /**
+   * std allocator drawing from the pool of the calling thread
+   */
+  template<class T> class PoolAllocator {
+  public:
+    typedef T value_type;
+
+    PoolAllocator() {}
+
+    template<class U> PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+      return static_cast<T*>(Pool::acquire(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) {
+      Pool::recycle(p, n * sizeof(T));
+    }
+
+    template<class U> struct rebind { typedef PoolAllocator<U> other; };
+
+    template<class U> bool operator==(const PoolAllocator<U>&) const { return true; }
+    template<class U> bool operator!=(const PoolAllocator<U>&) const { return false; }
+  };
+}
+
+#endif
@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_TAPE_HPP
+#define TNP_TAPE_HPP 1
+
+#include <vector>
+#include <utility>
+
+#include <tnp/npnumber.hpp>
+#include <tnp/npnumberview.hpp>
+
+/**
+ * Recording and replay of NPNumber programs.
+ * A model written as a template over its number type runs once on TapeNumbers,
+ * which record every operation into a Tape instead of computing it:
+ *   Tape tape(params, order);
+ *   tape.output(model(tape.input(), tape.input()));
+ * A TapeEvaluator then replays the tape on new inputs as a loop over the instructions,
+ * on a slot arena allocated once, without dispatch on the operands or allocations.
+ */
+namespace tnp {
+
+  enum TapeOp {
+    TAPE_CONSTANT,   // target = scalar
+    TAPE_ADD,        // target = a + b
+    TAPE_SUB,        // target = a - b
+    TAPE_MUL,        // target = a * b
+    TAPE_ADD_SCALAR, // target = a + scalar
+    TAPE_SCALE,      // target = a * scalar
+    TAPE_POW_INT,    // target = a^n
+    TAPE_POW_REAL,   // target = a^scalar
+    TAPE_POW,        // target = a^b
+    TAPE_ATAN2,      // target = atan2(a, b)
+    TAPE_HYPOT,      // target = hypot(a, b)
+    TAPE_SQRT,
+    TAPE_CBRT,
+    TAPE_EXP,
+    TAPE_LOG,
+    TAPE_APPLY,      // target = f(a) of the registered function n
+    TAPE_SINCOS,     // target = sin(a), b = cos(a)
+    TAPE_SINHCOSH    // target = sinh(a), b = cosh(a)
+  };
+
+  /**
+   * one operation on slots of the arena, unused fields are 0
+   */
+  struct TapeInstruction {
+    TapeOp op;
+    unsigned int target;
+    unsigned int a;
+    /* the second operand, or the second result of TAPE_SINCOS and TAPE_SINHCOSH */
+    unsigned int b;
+    int n;
+    double scalar;
+
+    /**
+     * true if b is written, not read
+     */
+    bool twoResults() const { return op == TAPE_SINCOS || op == TAPE_SINHCOSH; }
+
+    /**
+     * number of slot operands read: a and, for binary operations, b
+     */
+    unsigned int operands() const;
+  };
+
+  class Tape;
+
+  /**
+   * A number while recording, a slot of its tape. Mirrors the operations of NPNumber,
+   * so that a model written as a template runs on both. The tape must outlive its numbers
+   * and must not be moved while they are used. Operands and outputs of another tape
+   * are recorded as NaN constants.
+   */
+  class TapeNumber {
+    Tape* tape;
+    unsigned int _slot;
+
+    friend class Tape;
+
+    TapeNumber unary(TapeOp op, int n, double scalar) const;
+    TapeNumber binary(TapeOp op, const TapeNumber& o) const;
+    std::pair<TapeNumber, TapeNumber> twoResults(TapeOp op) const;
+
+  public:
+    TapeNumber(Tape* tape, unsigned int slot) : tape(tape), _slot(slot) {}
+
+    unsigned int slot() const { return _slot; }
+
+    TapeNumber operator+(const TapeNumber& o) const { return binary(TAPE_ADD, o); }
+    TapeNumber operator+(const double o) const { return unary(TAPE_ADD_SCALAR, 0, o); }
+    TapeNumber operator-(const TapeNumber& o) const { return binary(TAPE_SUB, o); }
+    TapeNumber operator-(const double o) const { return unary(TAPE_ADD_SCALAR, 0, -o); }
+    TapeNumber operator*(const TapeNumber& o) const { return binary(TAPE_MUL, o); }
+    TapeNumber operator*(const double f) const { return unary(TAPE_SCALE, 0, f); }
+
+    TapeNumber& operator+=(const TapeNumber& o) { return *this = *this + o; }
+    TapeNumber& operator+=(const double o) { return *this = *this + o; }
+    TapeNumber& operator-=(const TapeNumber& o) { return *this = *this - o; }
+    TapeNumber& operator-=(const double o) { return *this = *this - o; }
+    TapeNumber& operator*=(const TapeNumber& o) { return *this = *this * o; }
+    TapeNumber& operator*=(const double f) { return *this = *this * f; }
+
+    TapeNumber pow(int n) const { return unary(TAPE_POW_INT, n, 0.0); }
+    TapeNumber pow(unsigned int n) const { return pow((int)n); }
+    TapeNumber pow(double alpha) const { return unary(TAPE_POW_REAL, 0, alpha); }
+    TapeNumber pow(const TapeNumber& e) const { return binary(TAPE_POW, e); }
+
+    TapeNumber atan2(const TapeNumber& x) const { return binary(TAPE_ATAN2, x); }
+    TapeNumber hypot(const TapeNumber& o) const { return binary(TAPE_HYPOT, o); }
+
+    TapeNumber sqrt() const { return unary(TAPE_SQRT, 0, 0.0); }
+    TapeNumber cbrt() const { return unary(TAPE_CBRT, 0, 0.0); }
+    TapeNumber exp() const { return unary(TAPE_EXP, 0, 0.0); }
+    TapeNumber log() const { return unary(TAPE_LOG, 0, 0.0); }
+
+    /**
+     * applies a function registered in the FunctionRegistry, a NaN constant for an unknown id
+     */
+    TapeNumber apply(unsigned int function) const;
+
+    std::pair<TapeNumber, TapeNumber> sincos() const { return twoResults(TAPE_SINCOS); }
+    std::pair<TapeNumber, TapeNumber> sinhcosh() const { return twoResults(TAPE_SINHCOSH); }
+  };
+
+  /**
+   * A recorded program: the instructions over numbered slots, the slots of the inputs
+   * (in the order of input()) and of the outputs (in the order of output()).
+   * All numbers of a tape have the same shape.
+   */
+  class Tape {
+    unsigned int _params;
+    unsigned int _order;
+    unsigned int _slots;
+    std::vector<TapeInstruction> _instructions;
+    std::vector<unsigned int> _inputs;
+    std::vector<unsigned int> _outputs;
+
+  public:
+    Tape(unsigned int params, unsigned int order) : _params(params), _order(order), _slots(0) {}
+
+    /**
+     * a tape from its parts, e.g. a rewritten one
+     */
+    Tape(unsigned int params, unsigned int order, unsigned int slots,
+	 const std::vector<TapeInstruction>& instructions,
+	 const std::vector<unsigned int>& inputs, const std::vector<unsigned int>& outputs) :
+      _params(params), _order(order), _slots(slots), _instructions(instructions),
+      _inputs(inputs), _outputs(outputs) {}
+
+    unsigned int params() const { return _params; }
+    unsigned int order() const { return _order; }
+
+    /**
+     * fields of a slot
+     */
+    unsigned int size() const { return (_params + 1) * (_order + 1); }
+
+    unsigned int slots() const { return _slots; }
+
+    const std::vector<TapeInstruction>& instructions() const { return _instructions; }
+    const std::vector<unsigned int>& inputs() const { return _inputs; }
+    const std::vector<unsigned int>& outputs() const { return _outputs; }
+
+    /**
+     * a new input, its fields are set by the evaluator
+     */
+    TapeNumber input();
+
+    TapeNumber constant(double value);
+
+    /**
+     * marks a number as the next output
+     */
+    void output(const TapeNumber& n);
+
+    /**
+     * true if numbers has one number of the shape of the tape per input
+     */
+    bool accepts(const std::vector<NPNumber>& numbers) const;
+
+    void output(const std::vector<TapeNumber>& ns) {
+      for (const TapeNumber& n : ns)
+	output(n);
+    }
+
+    /**
+     * a fresh slot
+     */
+    unsigned int allocate() { return _slots++; }
+
+    /**
+     * appends an instruction, its target slots must be fresh
+     */
+    void record(const TapeInstruction& i) { _instructions.push_back(i); }
+  };
+
+  /**
+   * Replays a tape on an arena of tape.slots() numbers, allocated once with the scratch
+   * memory of the elementary functions. Write the inputs into input() (or seed() their values),
+   * run() and read the outputs from output(). The evaluator keeps a copy of the tape,
+   * e.g. of the result of TapeOptimizer::optimize().
+   */
+  class TapeEvaluator {
+    const Tape tape;
+    const unsigned int width;
+    const unsigned int size;
+    std::vector<double> arena;
+    std::vector<double> scratch;
+
+    inline double* slot(unsigned int s) { return arena.data() + s*size; }
+
+  public:
+    explicit TapeEvaluator(const Tape& tape);
+
+    /**
+     * fields of scratch memory execute() needs for the shape of a tape
+     */
+    static unsigned int scratchSize(unsigned int order, unsigned int width);
+
+    /**
+     * evaluates one instruction on the slots of an arena with slots of (order+1)*width fields
+     */
+    static void execute(const TapeInstruction& i, double* arena, unsigned int order, unsigned int width,
+			double* scratch);
+
+    /**
+     * the fields of input i
+     */
+    NPNumberView input(unsigned int i) {
+      return NPNumberView(slot(tape.inputs()[i]), tape.params(), tape.order());
+    }
+
+    /**
+     * sets the value of input i, keeping its derivatives
+     */
+    void seed(unsigned int i, double value) { slot(tape.inputs()[i])[0] = value; }
+
+    ConstNPNumberView output(unsigned int i) const {
+      return ConstNPNumberView(arena.data() + tape.outputs()[i]*size, tape.params(), tape.order());
+    }
+
+    /**
+     * evaluates all instructions in order
+     */
+    void run();
+
+    /**
+     * writes the inputs, runs the tape and returns copies of the outputs,
+     * no outputs if the tape does not accept the inputs
+     */
+    std::vector<NPNumber> operator()(const std::vector<NPNumber>& inputs);
+  };
+}
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_TAPE_COMPILER_HPP
+#define TNP_TAPE_COMPILER_HPP 1
+
+#include <string>
+#include <memory>
+#include <cstdint>
+
+#include <tnp/tape.hpp>
+
+namespace tnp {
+
+  /**
+   * signature of the instructions the generated code leaves to the library:
+   * evaluates instruction i of the tape behind context on the arena
+   */
+  typedef void (*TapeKernel)(const void* context, unsigned int i, double* arena, double* scratch);
+
+  /**
+   * signature of the entry point of a compiled tape
+   */
+  typedef void (*TapeEntry)(double* arena, double* scratch, TapeKernel kernel, const void* context);
+
+  /**
+   * A tape bound to native code from TapeCompiler, used like a TapeEvaluator.
+   * If the tape could not be compiled, compiled() is false and run() interprets the tape,
+   * so the results are the same either way.
+   */
+  class CompiledTape {
+    const Tape tape;
+    const unsigned int width;
+    const unsigned int size;
+    std::vector<double> arena;
+    std::vector<double> scratch;
+
+    /* keeps the shared object loaded while the entry point is used */
+    std::shared_ptr<void> library;
+    TapeEntry entry;
+
+    static void kernel(const void* context, unsigned int i, double* arena, double* scratch);
+
+    inline double* slot(unsigned int s) { return arena.data() + s*size; }
+
+  public:
+    CompiledTape(const Tape& tape, std::shared_ptr<void> library, TapeEntry entry);
+
+    /**
+     * true if run() executes native code
+     */
+    bool compiled() const { return entry != 0; }
+
+    NPNumberView input(unsigned int i) {
+      return NPNumberView(slot(tape.inputs()[i]), tape.params(), tape.order());
+    }
+
+    void seed(unsigned int i, double value) { slot(tape.inputs()[i])[0] = value; }
+
+    ConstNPNumberView output(unsigned int i) const {
+      return ConstNPNumberView(arena.data() + tape.outputs()[i]*size, tape.params(), tape.order());
+    }
+
+    void run();
+
+    /**
+     * as TapeEvaluator::operator(), no outputs if the tape does not accept the inputs
+     */
+    std::vector<NPNumber> operator()(const std::vector<NPNumber>& inputs);
+  };
+
+  /**
+   * Translates tapes of a fixed shape into C, builds them with the system C compiler
+   * and loads the result with dlopen.
+   *
+   * The generated function runs the instructions in order on the arena of the tape.
+   * Constants, sums, differences, scalar operations and products are emitted inline with
+   * all bounds and binomials as constants, the products unrolled over the terms of each row.
+   * They sum the same terms in the same order as Multiplication::apply() and the default flags
+   * are those of the library build, so the results are bitwise those of TapeEvaluator.
+   * The remaining instructions (elementary functions, powers and registered functions) choose
+   * their kernels from the arguments at run time and call back into TapeEvaluator::execute().
+   *
+   * Shared objects are cached by the hash of the source, the compiler command and the processor,
+   * in memory for the process and as files in the cache directory across processes,
+   * so a tape is compiled once. The cache directory must be a directory of the user with mode 0700,
+   * it is created if missing. Files are created under unique names and renamed when complete,
+   * a cached object is only loaded if it still has the checksum recorded when it was built.
+   */
+  class TapeCompiler {
+    std::string _compiler;
+    std::string _flags;
+    std::string _directory;
+
+  public:
+    /**
+     * the compiler is taken from TNP_TAPE_COMPILER, otherwise the C compiler of the build is used.
+     * The cache directory is TNP_TAPE_CACHE, otherwise tnp-tapes in $XDG_CACHE_HOME or $HOME/.cache.
+     * Without any of them tapes are interpreted.
+     */
+    TapeCompiler();
+
+    TapeCompiler(const std::string& compiler, const std::string& flags, const std::string& directory);
+
+    const std::string& compiler() const { return _compiler; }
+    const std::string& flags() const { return _flags; }
+    const std::string& directory() const { return _directory; }
+
+    /**
+     * the C source of a tape, the entry point is tnp_tape_run (see TapeEntry)
+     */
+    static std::string source(const Tape& tape);
+
+    /**
+     * FNV-1a of the shape, the instructions, the inputs and the outputs of a tape
+     */
+    static std::uint64_t hash(const Tape& tape);
+
+    /**
+     * the tape bound to its compiled code, loaded from the caches if possible.
+     * If compiling or loading fails, or the cache directory is not private, the result interprets the tape.
+     */
+    CompiledTape compile(const Tape& tape) const;
+
+    /**
+     * the shared object for a tape, NULL if it could not be built or loaded
+     */
+    std::shared_ptr<void> load(const Tape& tape) const;
+  };
+}
+
+#endif
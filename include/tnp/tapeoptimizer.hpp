@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_TAPE_OPTIMIZER_HPP
+#define TNP_TAPE_OPTIMIZER_HPP 1
+
+#include <ostream>
+
+#include <tnp/tape.hpp>
+
+namespace tnp {
+
+  /**
+   * Rewrites recorded tapes (every slot written once) into equivalent, shorter ones.
+   * The passes run in the order of their flags:
+   *  - TAPE_FOLD evaluates instructions on constants only to constants, with the values
+   *    NPNumber gives for constants, and turns sums, differences, products and powers with
+   *    one constant operand into their scalar forms,
+   *  - TAPE_CSE lets repeated instructions (same operation on the same slots) reuse the first result,
+   *  - TAPE_DCE removes instructions that no output depends on,
+   *  - TAPE_SLOTS renumbers the slots so that a slot is reused once its value is no longer read.
+   *    Targets never share a slot with the operands of their instruction, inputs and outputs keep
+   *    their own slots. The result is no longer a recorded tape, so this pass runs last.
+   * CSE and DCE keep the results bitwise, folding may change constants by a few ulps.
+   */
+  class TapeOptimizer {
+  public:
+    enum Pass {
+      TAPE_FOLD = 1,
+      TAPE_CSE = 2,
+      TAPE_DCE = 4,
+      TAPE_SLOTS = 8,
+      TAPE_ALL = 15
+    };
+
+    /**
+     * what the passes did
+     */
+    struct Report {
+      unsigned int instructionsBefore;
+      unsigned int instructionsAfter;
+      unsigned int slotsBefore;
+      unsigned int slotsAfter;
+      /* instructions replaced by constants */
+      unsigned int folded;
+      /* instructions replaced by scalar forms */
+      unsigned int simplified;
+      /* instructions replaced by earlier results */
+      unsigned int common;
+      /* instructions removed as dead */
+      unsigned int dead;
+    };
+
+    static Tape optimize(const Tape& tape, unsigned int passes = TAPE_ALL, Report* report = 0);
+
+    static Tape fold(const Tape& tape, Report& report);
+
+    static Tape eliminateCommon(const Tape& tape, Report& report);
+
+    static Tape eliminateDead(const Tape& tape, Report& report);
+
+    static Tape allocateSlots(const Tape& tape);
+  };
+
+  std::ostream& operator<<(std::ostream& out, const TapeOptimizer::Report& r);
+}
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TNP_TRANSPOSED_NPNUMBER_HPP
+#define TNP_TRANSPOSED_NPNUMBER_HPP 1
+
+#include <vector>
+#include <cmath>
+#include <ostream>
+
+#include <tnp/npnumber.hpp>
+#include <tnp/npnumberview.hpp>
+#include <tnp/fieldvector.hpp>
+#include <tnp/ops/multiplication.hpp>
+#include <tnp/ops/composition.hpp>
+#include <tnp/ops/layout.hpp>
+
+namespace tnp {
+
+  using namespace tnp::ops;
+
+  /**
+   * An AD-number in the parameter-major layout: the fields of parameter j (0 for the total
+   * derivatives) are the contiguous series series(j)[0..order]. Products and compositions
+   * run the transposed kernels and give the same fields as NPNumber, the conversions
+   * transpose tile by tile.
+   */
+  class TransposedNPNumber {
+    unsigned int _order;
+    unsigned int width;
+    FieldVector values;
+
+    TransposedNPNumber(unsigned int params, unsigned int order, FieldVector::Uninitialized u) :
+      _order(order), width(params + 1), values(width * (order + 1), u) {}
+
+  public:
+    TransposedNPNumber(unsigned int params, unsigned int order) : _order(order), width(params + 1),
+								  values(width * (order + 1)) {}
+
+    /**
+     * a constant
+     */
+    TransposedNPNumber(unsigned int params, unsigned int order, double value) :
+      _order(order), width(params + 1), values(width * (order + 1)) {
+      values[0] = value;
+    }
+
+    /**
+     * transposes the fields of a number or of any view
+     */
+    explicit TransposedNPNumber(const ConstNPNumberView& n) :
+      _order(n.order()), width(n.params() + 1), values(width * (n.order() + 1), FieldVector::Uninitialized()) {
+      if (n.contiguous()) {
+	Layout::toParameterMajor(n.data(), values.data(), _order, width);
+      } else {
+	FieldVector packed(values.size(), FieldVector::Uninitialized());
+	n.copyTo(packed.data());
+	Layout::toParameterMajor(packed.data(), values.data(), _order, width);
+      }
+    }
+
+    /**
+     * the fields in the order-major layout of NPNumber
+     */
+    NPNumber toNPNumber() const {
+      FieldVector fields(values.size(), FieldVector::Uninitialized());
+      Layout::toOrderMajor(values.data(), fields.data(), _order, width);
+      return NPNumber(width, std::move(fields));
+    }
+
+    unsigned int order() const { return _order; }
+    unsigned int params() const { return width - 1; }
+
+    const FieldVector& data() const { return values; }
+
+    /**
+     * the derivatives of order 0 .. order() of a parameter, or the total derivatives for 0
+     */
+    const double* series(const unsigned int param) const { return values.data() + param*(_order + 1); }
+
+    double* series(const unsigned int param) { return values.data() + param*(_order + 1); }
+
+    inline double der(const unsigned int param, const unsigned int order) const {
+      return values[param*(_order + 1) + order];
+    }
+
+    inline double& der(const unsigned int param, const unsigned int order) {
+      return values[param*(_order + 1) + order];
+    }
+
+    bool operator==(const TransposedNPNumber& o) const {
+      return width == o.width && values == o.values;
+    }
+
+    /* addition */
+    TransposedNPNumber& operator+=(const TransposedNPNumber& o) {
+      for (unsigned int i = 0; i < values.size(); ++i)
+	values[i] += o.values[i];
+      return *this;
+    }
+
+    TransposedNPNumber& operator+=(const double o) {
+      values[0] += o;
+      return *this;
+    }
+
+    TransposedNPNumber& operator-=(const TransposedNPNumber& o) {
+      for (unsigned int i = 0; i < values.size(); ++i)
+	values[i] -= o.values[i];
+      return *this;
+    }
+
+    TransposedNPNumber& operator-=(const double o) {
+      values[0] -= o;
+      return *this;
+    }
+
+    TransposedNPNumber operator+(const TransposedNPNumber& o) const { return TransposedNPNumber(*this) += o; }
+
+    TransposedNPNumber operator+(const double o) const { return TransposedNPNumber(*this) += o; }
+
+    TransposedNPNumber operator-(const TransposedNPNumber& o) const { return TransposedNPNumber(*this) -= o; }
+
+    TransposedNPNumber operator-(const double o) const { return TransposedNPNumber(*this) -= o; }
+
+    /* multiplication */
+    TransposedNPNumber operator*(const TransposedNPNumber& o) const {
+      TransposedNPNumber res(params(), _order, FieldVector::Uninitialized());
+      Multiplication::ensureExistance(_order).applyTransposed(values.data(), o.values.data(),
+							      res.values.data(), width);
+      return res;
+    }
+
+    TransposedNPNumber& operator*=(const TransposedNPNumber& o) {
+      return *this = *this * o;
+    }
+
+    TransposedNPNumber& operator*=(const double f) {
+      for (unsigned int i = 0; i < values.size(); ++i)
+	values[i] *= f;
+      return *this;
+    }
+
+    TransposedNPNumber operator*(const double f) const { return TransposedNPNumber(*this) *= f; }
+
+    /**
+     * applies a function given by its order+2 derivatives at the value of this number
+     */
+    TransposedNPNumber compose(const std::vector<double>& f) const {
+      TransposedNPNumber res(params(), _order, FieldVector::Uninitialized());
+      CompositionCache::staticGetInstance(_order)->applyTransposed(f.data(), values.data(),
+								   res.values.data(), width);
+      return res;
+    }
+
+    TransposedNPNumber exp() const {
+      return compose(std::vector<double>(_order + 2, std::exp(values[0])));
+    }
+  };
+
+  inline std::ostream& operator<<(std::ostream& out, const TransposedNPNumber& n) {
+    return out << n.toNPNumber();
+  }
+}
+
+#endif
@@ -18,6 +18,9 @@
  */
 
 #include <tnp/ops/composition.hpp>
+#include <tnp/ops/fixed.hpp>
+
+#include <array>
 
 namespace tnp {
   namespace ops {
@@ -93,17 +96,193 @@ namespace tnp {
       return b;
     }
     
+    double Composition::compileValueCost() const {
+      double cost = last->valueCost;
+      for (const SumOfProducts& s : bell_polynomials) {
+	for (const Product& p : s.sum)
+	  cost += p.fields.size() + 1;
+	cost += 1;
+      }
+      return cost;
+    }
+
+    double Composition::compileDerCost() const {
+      double cost = last->derCost;
+      for (const DerSumOfProducts& s : der_bell_polynomials) {
+	for (const DerProduct& p : s.sum)
+	  cost += p.fields.size() + 1;
+	cost += 3;
+      }
+      return cost;
+    }
+
     void Composition::apply(const vector<double>& f, const vector<double>& a,
 			    vector<double>& target, const unsigned int width) const {
       apply(f.data(), a.data(), target.data(), width);
     }
     
+    unsigned int Composition::degree(const double* a, unsigned int order, unsigned int width) {
+      for (unsigned int n = order; n > 0; --n)
+	for (unsigned int j = 0; j < width; ++j)
+	  if (a[n*width + j] != 0.0)
+	    return n;
+      return 0;
+    }
+
+    void Composition::apply(const double* f, const double* a,
+			    double* target, unsigned int width) const {
+      apply(f, a, target, width, degree(a, order, width));
+    }
+
     void Composition::apply(const double* f, const double* a,
-		 double* target, unsigned int width) const {
+			    double* target, unsigned int width, unsigned int degree) const {
+      if (degree <= 1) {
+	applyAffine(f, a, target, width);
+	return;
+      }
+
+      const Kernel fixed = fixedKernel(width);
+      if (fixed)
+	(this->*fixed)(f, a, target);
+      else
+	applyBell(f, a, target, width);
+    }
+
+    template<unsigned int W> 
+    void Composition::applyBellFixed(const double* f, const double* a, double* target) const {
+      if (order > 0) {
+	last->applyBellFixed<W>(f, a, target);
+
+	std::array<double, W> t;
+	t.fill(0.0);
+
+	for (unsigned int k = 0; k < order; k++) {
+	  const SumOfProducts& bellK = bell_polynomials[k];
+	  const DerSumOfProducts& dBellK = der_bell_polynomials[k];
+	  const double bell = bellK.eval(a, W);
+
+	  t[0] += f[k+1] * bell;
+
+	  // all columns of dBellK.eval(a, W, j) in one pass over the products
+	  std::array<double, W> dBell;
+	  dBell.fill(0.0);
+	  SumOfProducts::evals.fetch_add(dBellK.sum.size(), std::memory_order_relaxed);
+	  for (const DerProduct& p : dBellK.sum) {
+	    std::array<double, W> prod;
+	    prod.fill(p.factor);
+	    for (DerProductField field : p.fields) {
+	      const double* row = a + field.key*W;
+	      if (field.is_der) {
+		for (unsigned int j = 1; j < W; ++j)
+		  prod[j] *= row[j];
+	      } else {
+		for (unsigned int j = 1; j < W; ++j)
+		  prod[j] *= row[0];
+	      }
+	    }
+	    for (unsigned int j = 1; j < W; ++j)
+	      dBell[j] += prod[j];
+	  }
+
+	  for (unsigned int j = 1; j < W; ++j)
+	    t[j] += f[k+2] * a[j] * bell + f[k+1] * dBell[j];
+	}
+
+	for (unsigned int j = 0; j < W; ++j)
+	  target[order*W + j] = t[j];
+      } else {
+	target[0] = f[0];
+	for (unsigned int j = 1; j < W; ++j)
+	  target[j] = f[1] * a[j];
+      }
+    }
+
+    template<class T, class Acc>
+    void Composition::applyScalar(const Acc* f, const T* a, T* target, unsigned int width) const {
+
+      const unsigned int params = width - 1;
+      if (order > 0) {
+	last->applyScalar<T, Acc>(f, a, target, width);
+
+	vector<Acc> t(width, 0.0);
+	for (unsigned int k = 0; k < order; k++) {
+	  const Acc bell = bell_polynomials[k].eval<T, Acc>(a, width);
+
+	  t[0] += f[k+1] * bell;
+	  for (unsigned int j = 1; j <= params; ++j)
+	    t[j] += f[k+2] * a[j] * bell + f[k+1] * der_bell_polynomials[k].eval<T, Acc>(a, width, j);
+	}
+
+	for (unsigned int j = 0; j <= params; ++j)
+	  target[order*width + j] = T(t[j]);
+      } else {
+	target[0] = T(f[0]);
+	for (unsigned int j = 1; j <= params; ++j)
+	  target[j] = T(f[1] * a[j]);
+      }
+    }
+
+    template void Composition::applyScalar<float, float>(const float*, const float*, float*, unsigned int) const;
+    template void Composition::applyScalar<float, double>(const double*, const float*, float*, unsigned int) const;
+    template void Composition::applyScalar<double, double>(const double*, const double*, double*, unsigned int) const;
+    template void Composition::applyScalar<long double, long double>(const long double*, const long double*, 
+								      long double*, unsigned int) const;
+
+    namespace {
+      typedef Composition::Kernel KernelTable[FIXED_MAX_PARAMS + 1];
+
+      /* fills table[W-1] and all entries before it */
+      template<unsigned int W> struct FillKernels {
+	static void fill(KernelTable& table) {
+	  table[W - 1] = &Composition::applyBellFixed<W>;
+	  FillKernels<W - 1>::fill(table);
+	}
+      };
+
+      template<> struct FillKernels<0> {
+	static void fill(KernelTable&) {}
+      };
+
+      struct Kernels {
+	KernelTable table;
+	Kernels() { FillKernels<FIXED_MAX_PARAMS + 1>::fill(table); }
+      };
+    }
+
+    Composition::Kernel Composition::fixedKernel(unsigned int width) {
+      static const Kernels kernels;
+      if (!FixedKernels::enabled() || width > FIXED_MAX_PARAMS + 1)
+	return NULL;
+      return kernels.table[width - 1];
+    }
+
+    void Composition::applyAffine(const double* f, const double* a,
+				  double* target, unsigned int width) const {
+      // (f o x)^(n) = f^(n)(x) * (x')^n, 
+      // its partial derivative is f^(n+1)(x) * x_j * (x')^n + n * f^(n)(x) * (x')^(n-1) * x'_j
+      const unsigned int params = width - 1;
+      const double d = order > 0 ? a[width] : 0.0;
+
+      double dn = 1.0;
+      double dn1 = 0.0;
+      for (unsigned int n = 0; n <= order; ++n) {
+	target[n*width] = f[n] * dn;
+	for (unsigned int j = 1; j <= params; ++j) {
+	  target[n*width + j] = f[n+1] * a[j] * dn;
+	  if (n > 0)
+	    target[n*width + j] += n * f[n] * dn1 * a[width + j];
+	}
+	dn1 = dn;
+	dn *= d;
+      }
+    }
+
+    void Composition::applyBell(const double* f, const double* a,
+				double* target, unsigned int width) const {
 
       const unsigned int params = width - 1;
       if (order > 0) {
-	last->apply(f, a, target, width);
+	last->applyBell(f, a, target, width);
 
 	for (int j = 0 ; j <= params; ++j)
 	  target[order*width + j] = 0;
@@ -126,5 +305,119 @@ namespace tnp {
 	}
       }
     }
+
+    void Composition::applyTransposed(const double* f, const double* a,
+				      double* target, unsigned int width) const {
+      const unsigned int length = order + 1;
+
+      unsigned int degree = 0;
+      for (unsigned int j = 0; j < width; ++j)
+	for (unsigned int n = order; n > degree; --n)
+	  if (a[j*length + n] != 0.0)
+	    degree = n;
+
+      if (degree <= 1)
+	applyAffineTransposed(f, a, target, width);
+      else
+	applyBellTransposed(f, a, target, width, length);
+    }
+
+    void Composition::applyAffineTransposed(const double* f, const double* a,
+					    double* target, unsigned int width) const {
+      // applyAffine() with a[n*width + j] at a[j*length + n]
+      const unsigned int length = order + 1;
+      const double d = order > 0 ? a[1] : 0.0;
+
+      double dn = 1.0;
+      for (unsigned int n = 0; n <= order; ++n) {
+	target[n] = f[n] * dn;
+	dn *= d;
+      }
+
+      for (unsigned int j = 1; j < width; ++j) {
+	const double* aj = a + j*length;
+	double* tj = target + j*length;
+
+	double dn = 1.0;
+	double dn1 = 0.0;
+	for (unsigned int n = 0; n <= order; ++n) {
+	  tj[n] = f[n+1] * aj[0] * dn;
+	  if (n > 0)
+	    tj[n] += n * f[n] * dn1 * aj[1];
+	  dn1 = dn;
+	  dn *= d;
+	}
+      }
+    }
+
+    void Composition::applyBellTransposed(const double* f, const double* a, double* target,
+					  unsigned int width, unsigned int length) const {
+      if (order > 0) {
+	last->applyBellTransposed(f, a, target, width, length);
+
+	for (unsigned int j = 0; j < width; ++j)
+	  target[j*length + order] = 0;
+
+	for (unsigned int k = 0; k < order; k++) {
+	  const double bell = bell_polynomials[k].eval(a, 1);
+
+	  target[order] += f[k+1] * bell;
+
+	  for (unsigned int j = 1; j < width; ++j) {
+	    const double* aj = a + j*length;
+	    target[j*length + order] += f[k+2] * aj[0] * bell + f[k+1] * der_bell_polynomials[k].evalSeries(a, aj);
+	  }
+	}
+      } else {
+	target[0] = f[0];
+	for (unsigned int j = 1; j < width; ++j)
+	  target[j*length] = f[1] * a[j*length];
+      }
+    }
+
+    void Composition::applyMany(const double* f, unsigned int m, const double* a,
+				double* target, unsigned int width) const {
+      if (degree(a, order, width) <= 1) {
+	for (unsigned int i = 0; i < m; ++i)
+	  applyAffine(f + i*(order + 2), a, target + i*(order + 1)*width, width);
+      } else {
+	applyMany(f, order + 2, m, a, target, (order + 1) * width, width);
+      }
+    }
+
+    void Composition::applyMany(const double* f, unsigned int fStride, unsigned int m, const double* a,
+				double* target, unsigned int targetStride, unsigned int width) const {
+
+      const unsigned int params = width - 1;
+      if (order > 0) {
+	last->applyMany(f, fStride, m, a, target, targetStride, width);
+
+	for (unsigned int i = 0; i < m; ++i)
+	  for (unsigned int j = 0 ; j <= params; ++j)
+	    target[i*targetStride + order*width + j] = 0;
+
+	for (unsigned int k = 0; k < order; k++) {
+	  const SumOfProducts& bellK = bell_polynomials[k];
+	  const DerSumOfProducts& dBellK = der_bell_polynomials[k];
+	  const double bell = bellK.eval(a, width);
+	
+	  for (unsigned int i = 0; i < m; ++i)
+	    target[i*targetStride + order*width] += f[i*fStride + k+1] * bell;
+	  
+	  for (unsigned int j = 1; j <= params; ++j) {
+	    const double dBell = dBellK.eval(a, width, j);
+	    for (unsigned int i = 0; i < m; ++i)
+	      target[i*targetStride + order*width + j] += f[i*fStride + k+2] * a[j] * bell + f[i*fStride + k+1] * dBell;
+	  }
+	}
+      } else {
+	for (unsigned int i = 0; i < m; ++i) {
+	  target[i*targetStride] = f[i*fStride];
+	  for (unsigned int j = 1; j <= params; ++j) {
+	    target[i*targetStride + j] = f[i*fStride + 1] * a[j];
+	  }
+	}
+      }
+    }
   }
 }
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/context.hpp>
+
+namespace tnp {
+
+  Context::Context(unsigned int order) : prepared(-1), pool(new Pool()), method(POW_AUTOMATIC),
+					 isDefault(false) {
+    prepare(order);
+  }
+
+  Context::Context(Default) : prepared(-1), method(POW_AUTOMATIC), isDefault(true) {}
+
+  Context& Context::local() {
+    return *tnp_context_default();
+  }
+
+  void Context::prepare(unsigned int order) {
+    if ((int) order <= prepared)
+      return;
+
+    Multiplication::ensureExistance(order);
+    for (unsigned int n = compositions.size(); n <= order; ++n)
+      compositions.push_back(CompositionCache::staticGetInstance(n));
+    prepared = order;
+  }
+}
+
+extern "C" {
+
+  struct tnp_context* tnp_context_create(int order) {
+    if (order < 0)
+      return NULL;
+    return new tnp_context(order);
+  }
+
+  void tnp_context_delete(struct tnp_context* ctx) {
+    delete ctx;
+  }
+
+  struct tnp_context* tnp_context_default(void) {
+    static thread_local tnp_context local((tnp::Context::Default()));
+    return &local;
+  }
+
+  void tnp_context_prepare(struct tnp_context* ctx, int order) {
+    if (order < 0)
+      return;
+    ctx->prepare(order);
+  }
+
+  void tnp_context_pow_method(struct tnp_context* ctx, int method) {
+    if (method < tnp::ops::POW_AUTOMATIC || method > tnp::ops::POW_COMPOSITION)
+      return;
+    ctx->powerMethod() = (tnp::ops::PowerMethod) method;
+  }
+}
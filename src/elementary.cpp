@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/ops/elementary.hpp>
+#include <tnp/ops/composition.hpp>
+
+#include <cmath>
+#include <algorithm>
+
+namespace tnp {
+  namespace ops {
+
+    using namespace std;
+
+    void Elementary::accumulateRow(const double* y, const double* x, double* t, double factor,
+				   unsigned int n, unsigned int width, unsigned int degree) {
+      const unsigned int params = width - 1;
+      const vector<double>& binomial = Multiplication::cacheVector()[n-1].binomials();
+      t += n*width;
+
+      for (unsigned int k = n > degree ? n - degree : 0; k < n; ++k) {
+	const double c = factor * binomial[k];
+	const double* yk = y + k*width;
+	const double* xk = x + (n-k)*width;
+
+	t[0] += c * yk[0] * xk[0];
+	for (unsigned int j = 1; j <= params; ++j)
+	  t[j] += c * (yk[j] * xk[0] + yk[0] * xk[j]);
+      }
+    }
+
+    void Elementary::quotientRow(const double* r, double* y, unsigned int n, unsigned int width,
+				 unsigned int degree) {
+      const unsigned int params = width - 1;
+      const vector<double>& binomial = Multiplication::cacheVector()[n-1].binomials();
+      double* t = y + n*width;
+
+      for (unsigned int k = 1; k < n && k <= degree; ++k) {
+	const double c = binomial[k];
+	const double* rk = r + k*width;
+	const double* yk = y + (n-k)*width;
+
+	t[0] -= c * rk[0] * yk[0];
+	for (unsigned int j = 1; j <= params; ++j)
+	  t[j] -= c * (rk[j] * yk[0] + rk[0] * yk[j]);
+      }
+
+      const double inv = 1.0 / r[0];
+      t[0] *= inv;
+      for (unsigned int j = 1; j <= params; ++j)
+	t[j] = (t[j] - r[j] * t[0]) * inv;
+    }
+
+    void Elementary::exp(const double* a, double* target, unsigned int order, unsigned int width) {
+      const unsigned int params = width - 1;
+      Multiplication::ensureExistance(order);
+
+      const unsigned int degree = Composition::degree(a, order, width);
+
+      const double e = std::exp(a[0]);
+      target[0] = e;
+      for (unsigned int j = 1; j <= params; ++j)
+	target[j] = e * a[j];
+
+      for (unsigned int n = 1; n <= order; ++n) {
+	for (unsigned int j = 0; j <= params; ++j)
+	  target[n*width + j] = 0.0;
+	accumulateRow(target, a, target, 1.0, n, width, degree);
+      }
+    }
+
+    void Elementary::log(const double* a, double* target, unsigned int order, unsigned int width) {
+      const unsigned int params = width - 1;
+      Multiplication::ensureExistance(order);
+
+      const unsigned int degree = Composition::degree(a, order, width);
+
+      const double inv = 1.0 / a[0];
+      target[0] = std::log(a[0]);
+      for (unsigned int j = 1; j <= params; ++j)
+	target[j] = a[j] * inv;
+
+      for (unsigned int n = 1; n <= order; ++n) {
+	for (unsigned int j = 0; j <= params; ++j)
+	  target[n*width + j] = a[n*width + j];
+	quotientRow(a, target, n, width, degree);
+      }
+    }
+
+    void Elementary::coupled(const double* a, double* s, double* c, double sign,
+			     unsigned int order, unsigned int width) {
+      const unsigned int params = width - 1;
+      Multiplication::ensureExistance(order);
+      const unsigned int degree = Composition::degree(a, order, width);
+
+      for (unsigned int j = 1; j <= params; ++j) {
+	s[j] = c[0] * a[j];
+	c[j] = sign * s[0] * a[j];
+      }
+
+      for (unsigned int n = 1; n <= order; ++n) {
+	for (unsigned int j = 0; j <= params; ++j) {
+	  s[n*width + j] = 0.0;
+	  c[n*width + j] = 0.0;
+	}
+	accumulateRow(c, a, s, 1.0, n, width, degree);
+	accumulateRow(s, a, c, sign, n, width, degree);
+      }
+    }
+
+    void Elementary::sincos(const double* a, double* s, double* c, unsigned int order, unsigned int width) {
+      s[0] = std::sin(a[0]);
+      c[0] = std::cos(a[0]);
+      coupled(a, s, c, -1.0, order, width);
+    }
+
+    void Elementary::sinhcosh(const double* a, double* s, double* c, unsigned int order, unsigned int width) {
+      s[0] = std::sinh(a[0]);
+      c[0] = std::cosh(a[0]);
+      coupled(a, s, c, 1.0, order, width);
+    }
+
+    void Elementary::power(const double* a, double* target, double alpha,
+			   unsigned int order, unsigned int width) {
+      const unsigned int params = width - 1;
+      Multiplication::ensureExistance(order);
+
+      const unsigned int degree = Composition::degree(a, order, width);
+
+      const double dy = alpha * target[0] / a[0];
+      for (unsigned int j = 1; j <= params; ++j)
+	target[j] = dy * a[j];
+
+      for (unsigned int n = 1; n <= order; ++n) {
+	for (unsigned int j = 0; j <= params; ++j)
+	  target[n*width + j] = 0.0;
+	accumulateRow(target, a, target, alpha, n, width, degree);
+	quotientRow(a, target, n, width, degree);
+      }
+    }
+
+    void Elementary::pow(const double* a, double* target, double alpha, unsigned int order, unsigned int width) {
+      target[0] = std::pow(a[0], alpha);
+      power(a, target, alpha, order, width);
+    }
+
+    void Elementary::sqrt(const double* a, double* target, unsigned int order, unsigned int width) {
+      target[0] = std::sqrt(a[0]);
+      power(a, target, 0.5, order, width);
+    }
+
+    void Elementary::cbrt(const double* a, double* target, unsigned int order, unsigned int width) {
+      target[0] = std::cbrt(a[0]);
+      power(a, target, 1.0 / 3.0, order, width);
+    }
+
+    void Elementary::pow(const double* a, const double* b, double* target, unsigned int order, unsigned int width,
+			 double* scratch) {
+      const unsigned int params = width - 1;
+      Multiplication::ensureExistance(order);
+
+      const unsigned int degree = Composition::degree(a, order, width);
+
+      // z = exp(w), w = b * l, l = log(a), all three advanced one row at a time
+      vector<double> own(scratch ? 0 : scratchSize(order, width));
+      double* l = scratch ? scratch : own.data();
+      double* w = l + width * (order+1);
+
+      l[0] = std::log(a[0]);
+      w[0] = b[0] * l[0];
+      target[0] = std::exp(w[0]);
+      for (unsigned int j = 1; j <= params; ++j) {
+	l[j] = a[j] / a[0];
+	w[j] = b[j] * l[0] + b[0] * l[j];
+	target[j] = target[0] * w[j];
+      }
+
+      for (unsigned int n = 1; n <= order; ++n) {
+	for (unsigned int j = 0; j <= params; ++j) {
+	  l[n*width + j] = a[n*width + j];
+	  target[n*width + j] = 0.0;
+	}
+	quotientRow(a, l, n, width, degree);
+	Multiplication::cacheVector()[n].applyRow(b, l, w, width);
+	accumulateRow(target, w, target, 1.0, n, width, n);
+      }
+    }
+
+    void Elementary::atan2(const double* y, const double* x, double* target, unsigned int order, unsigned int width,
+			   double* scratch) {
+      const unsigned int params = width - 1;
+      Multiplication::ensureExistance(order);
+
+      const unsigned int xDegree = Composition::degree(x, order, width);
+      const unsigned int yDegree = Composition::degree(y, order, width);
+      const unsigned int rDegree = 2 * max(xDegree, yDegree);
+
+      // r = x^2 + y^2, kept one row ahead of the target
+      vector<double> own(scratch ? 0 : scratchSize(order, width));
+      double* r = scratch ? scratch : own.data();
+      double* s = r + width * (order+1);
+
+      Multiplication::cacheVector()[0].applyRow(x, x, r, width);
+      Multiplication::cacheVector()[0].applyRow(y, y, s, width);
+      for (unsigned int j = 0; j <= params; ++j)
+	r[j] += s[j];
+
+      target[0] = std::atan2(y[0], x[0]);
+      for (unsigned int j = 1; j <= params; ++j)
+	target[j] = (x[0] * y[j] - y[0] * x[j]) / r[0];
+
+      for (unsigned int n = 1; n <= order; ++n) {
+	for (unsigned int j = 0; j <= params; ++j)
+	  target[n*width + j] = 0.0;
+	accumulateRow(x, y, target, 1.0, n, width, yDegree);
+	accumulateRow(y, x, target, -1.0, n, width, xDegree);
+	quotientRow(r, target, n, width, rDegree);
+
+	if (n < order) {
+	  Multiplication::cacheVector()[n].applyRow(x, x, r, width);
+	  Multiplication::cacheVector()[n].applyRow(y, y, s, width);
+	  for (unsigned int j = 0; j <= params; ++j)
+	    r[n*width + j] += s[n*width + j];
+	}
+      }
+    }
+
+    void Elementary::hypot(const double* x, const double* y, double* target, unsigned int order, unsigned int width,
+			   double* scratch) {
+      const unsigned int params = width - 1;
+      Multiplication::ensureExistance(order);
+
+      // x^2 and y^2, advanced together with the target
+      vector<double> own(scratch ? 0 : scratchSize(order, width));
+      double* r = scratch ? scratch : own.data();
+      double* s = r + width * (order+1);
+
+      target[0] = std::hypot(x[0], y[0]);
+
+      for (unsigned int n = 0; n <= order; ++n) {
+	Multiplication::cacheVector()[n].applyRow(x, x, r, width);
+	Multiplication::cacheVector()[n].applyRow(y, y, s, width);
+
+	if (n == 0) {
+	  for (unsigned int j = 1; j <= params; ++j)
+	    target[j] = 0.5 * (r[j] + s[j]) / target[0];
+	} else {
+	  for (unsigned int j = 0; j <= params; ++j)
+	    target[n*width + j] = 0.5 * (r[n*width + j] + s[n*width + j]);
+	  quotientRow(target, target, n, width, n);
+	}
+      }
+    }
+  }
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/ops/functions.hpp>
+#include <tnp/ops/composition.hpp>
+
+namespace tnp {
+  namespace ops {
+
+    using namespace std;
+
+    void UnaryFunction::derivatives(double x, unsigned int n, double* f) const {
+      if (batch)
+	batch(x, n, f);
+      else
+	for (unsigned int k = 0; k <= n; ++k)
+	  f[k] = scalar(x, k);
+    }
+
+    void UnaryFunction::apply(const double* a, double* target, unsigned int order, unsigned int width,
+			      double* f) const {
+      // Composition reads f up to the (order+1)-th derivative for the parameter columns
+      vector<double> own(f ? 0 : order + 2);
+      if (!f)
+	f = own.data();
+      derivatives(a[0], order + 1, f);
+      CompositionCache::staticGetInstance(order)->apply(f, a, target, width);
+    }
+
+    const unsigned int FunctionRegistry::INVALID;
+
+    unsigned int FunctionRegistry::add(DerivativeGenerator scalar, BatchDerivativeGenerator batch) {
+      if (!scalar && !batch)
+	return INVALID;
+
+      lock_guard<mutex> l(lock());
+      const unsigned int id = functions().size();
+      functions().push_back(UnaryFunction(id, scalar, batch));
+      return id;
+    }
+  }
+}
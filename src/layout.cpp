@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/ops/layout.hpp>
+
+#include <algorithm>
+
+namespace tnp {
+  namespace ops {
+
+    void Layout::transpose(const double* src, double* dst, unsigned int rows, unsigned int cols) {
+      for (unsigned int rb = 0; rb < rows; rb += TRANSPOSE_BLOCK) {
+	const unsigned int rEnd = std::min(rb + TRANSPOSE_BLOCK, rows);
+	for (unsigned int cb = 0; cb < cols; cb += TRANSPOSE_BLOCK) {
+	  const unsigned int cEnd = std::min(cb + TRANSPOSE_BLOCK, cols);
+	  for (unsigned int c = cb; c < cEnd; ++c)
+	    for (unsigned int r = rb; r < rEnd; ++r)
+	      dst[c*rows + r] = src[r*cols + c];
+	}
+      }
+    }
+  }
+}
@@ -18,14 +18,54 @@
  */
 
 #include <tnp/ops/multiplication.hpp>
+#include <tnp/ops/fixed.hpp>
 #include <boost/math/special_functions/binomial.hpp>
 
 #include <vector>
 #include <map>
+#include <algorithm>
 
 namespace tnp {
   
   using namespace std;
+  using namespace tnp::ops;
+
+  namespace {
+    typedef Multiplication::Kernel KernelTable[FIXED_MAX_ORDER + 1][FIXED_MAX_PARAMS + 1];
+
+    /* fills table[O][P] and all entries before it */
+    template<unsigned int P, unsigned int O> struct FillKernels {
+      static void fill(KernelTable& table) {
+	table[O][P] = &FixedMultiplication<P, O>::apply;
+	FillKernels<P - 1, O>::fill(table);
+      }
+    };
+
+    template<unsigned int O> struct FillKernels<0, O> {
+      static void fill(KernelTable& table) {
+	table[O][0] = &FixedMultiplication<0, O>::apply;
+	FillKernels<FIXED_MAX_PARAMS, O - 1>::fill(table);
+      }
+    };
+
+    template<> struct FillKernels<0, 0> {
+      static void fill(KernelTable& table) {
+	table[0][0] = &FixedMultiplication<0, 0>::apply;
+      }
+    };
+
+    struct Kernels {
+      KernelTable table;
+      Kernels() { FillKernels<FIXED_MAX_PARAMS, FIXED_MAX_ORDER>::fill(table); }
+    };
+  }
+
+  Multiplication::Kernel Multiplication::fixedKernel(unsigned int order, unsigned int width) {
+    static const Kernels kernels;
+    if (!FixedKernels::enabled() || order > FIXED_MAX_ORDER || width > FIXED_MAX_PARAMS + 1)
+      return NULL;
+    return kernels.table[order][width - 1];
+  }
 
   vector<double> Multiplication::compileBinomial(const unsigned int order) {
     vector<double> b;
@@ -83,11 +123,29 @@ namespace tnp {
   void Multiplication::apply(const double* a, const double* b,
 			     double* target, unsigned int width) const {
 
-    unsigned int params = width - 1;
-    
+    const Kernel fixed = fixedKernel(order, width);
+    if (fixed) {
+      fixed(a, b, target);
+      return;
+    }
+
+    applyGeneric(a, b, target, width);
+  }
+
+  void Multiplication::applyGeneric(const double* a, const double* b,
+				    double* target, unsigned int width) const {
+
     if (order > 0)
-      cacheVector()[order-1].apply(a, b, target, width);
+      cacheVector()[order-1].applyGeneric(a, b, target, width);
       
+    applyRow(a, b, target, width);
+  }
+
+  void Multiplication::applyRow(const double* a, const double* b,
+				double* target, unsigned int width) const {
+
+    unsigned int params = width - 1;
+
     evalValue(a, b, target, width);
       
     for (int j = 1; j <= params; ++j) {
@@ -95,10 +153,148 @@ namespace tnp {
     }
   }
 
-  vector<Multiplication>& Multiplication::cacheVectorInitialized(const unsigned int upTo) {
-    while (upTo >= cacheVector().size()) {
-      cacheVector().push_back(Multiplication(cacheVector().size()));      
+  void Multiplication::applyInPlace(const double* a, const double* b,
+				    double* target, unsigned int width) const {
+
+    unsigned int params = width - 1;
+
+    for (int n = order; n >= 0; --n) {
+      const Multiplication& row = cacheVector()[n];
+      for (int j = params; j >= 1; --j)
+	row.evalPartialDerivative(a, b, target, width, j);
+      row.evalValue(a, b, target, width);
+    }
+  }
+
+  void Multiplication::accumulate(const double* a, const double* b, double* target,
+				  double factor, unsigned int width) const {
+
+    unsigned int params = width - 1;
+
+    for (unsigned int n = 0; n <= order; ++n) {
+      const vector<double>& binomial = cacheVector()[n].binomial;
+      double* t = target + n*width;
+
+      double d = 0;
+      for (unsigned int k = 0; k <= n; ++k)
+	d += binomial[k] * a[(n - k)*width] * b[k * width];
+      t[0] += factor * d;
+
+      for (unsigned int j = 1; j <= params; ++j) {
+	d = 0;
+	for (unsigned int k = 0; k <= n; ++k) {
+	  const double c = binomial[k];
+	  d += c * a[(n - k)*width +j] * b[k * width];
+	  d += c * a[(n - k)*width] * b[k * width +j];
+	}
+	t[j] += factor * d;
+      }
+    }
+  }
+
+  void Multiplication::applyPadded(const double* a, const double* b, double* target,
+				   unsigned int, unsigned int stride) const {
+    applyRows(a, b, target, stride, stride);
+  }
+
+  void Multiplication::applyStrided(const double* a, const double* b, double* target,
+				    unsigned int width, unsigned int stride) const {
+    applyRows(a, b, target, width, stride);
+  }
+
+  void Multiplication::applyRows(const double* a, const double* b, double* target,
+				 unsigned int columns, unsigned int stride) const {
+
+    for (unsigned int n = 0; n <= order; ++n) {
+      const vector<double>& binomial = cacheVector()[n].binomial;
+      double* t = target + n*stride;
+
+      std::fill(t, t + columns, 0.0);
+
+      double d = 0;
+      for (unsigned int k = 0; k <= n; ++k) {
+	const double c = binomial[k];
+	const double* ak = a + (n - k)*stride;
+	const double* bk = b + k*stride;
+
+	d += c * ak[0] * bk[0];
+
+	// column 0 gets 2*c*a0*b0 here and is overwritten below
+	const double ca = c * ak[0];
+	for (unsigned int j = 0; j < columns; ++j) {
+	  t[j] += c * ak[j] * bk[0];
+	  t[j] += ca * bk[j];
+	}
+      }
+      t[0] = d;
     }
+  }
+
+  void Multiplication::applyTransposed(const double* a, const double* b, double* target,
+				       unsigned int width) const {
+
+    const unsigned int length = order + 1;
+
+    for (unsigned int n = 0; n <= order; ++n) {
+      const vector<double>& binomial = cacheVector()[n].binomial;
+      double d = 0;
+      for (unsigned int k = 0; k <= n; ++k)
+	d += binomial[k] * a[n - k] * b[k];
+      target[n] = d;
+    }
+
+    for (unsigned int j = 1; j < width; ++j) {
+      const double* aj = a + j*length;
+      const double* bj = b + j*length;
+      double* tj = target + j*length;
+
+      for (unsigned int n = 0; n <= order; ++n) {
+	const vector<double>& binomial = cacheVector()[n].binomial;
+	double d = 0;
+	for (unsigned int k = 0; k <= n; ++k) {
+	  const double c = binomial[k];
+	  d += c * aj[n - k] * b[k];
+	  d += c * a[n - k] * bj[k];
+	}
+	tj[n] = d;
+      }
+    }
+  }
+
+  template<class T, class Acc>
+  void Multiplication::applyScalar(const T* a, const T* b, T* target, unsigned int width) const {
+
+    unsigned int params = width - 1;
+
+    for (unsigned int n = 0; n <= order; ++n) {
+      const vector<double>& binomial = cacheVector()[n].binomial;
+      T* t = target + n*width;
+
+      Acc d = 0;
+      for (unsigned int k = 0; k <= n; ++k)
+	d += Acc(binomial[k]) * a[(n - k)*width] * b[k * width];
+      t[0] = T(d);
+
+      for (unsigned int j = 1; j <= params; ++j) {
+	d = 0;
+	for (unsigned int k = 0; k <= n; ++k) {
+	  const Acc c = binomial[k];
+	  d += c * a[(n - k)*width +j] * b[k * width];
+	  d += c * a[(n - k)*width] * b[k * width +j];
+	}
+	t[j] = T(d);
+      }
+    }
+  }
+
+  template void Multiplication::applyScalar<float, float>(const float*, const float*, float*, unsigned int) const;
+  template void Multiplication::applyScalar<float, double>(const float*, const float*, float*, unsigned int) const;
+  template void Multiplication::applyScalar<double, double>(const double*, const double*, double*, unsigned int) const;
+  template void Multiplication::applyScalar<long double, long double>(const long double*, const long double*, 
+								       long double*, unsigned int) const;
+
+  OrderTable<Multiplication>& Multiplication::cacheVectorInitialized(const unsigned int upTo) {
+    cacheVector().grow(upTo, &make);
     return cacheVector();
   }
   
@@ -21,6 +21,7 @@
 #include <functional>
 #include <algorithm>
 #include <cmath>
+#include <mutex>
 
 #include "prettyprint.hpp"
 
@@ -41,104 +42,333 @@ namespace tnp {
     return v;
   }
 
+  void NPNumber::buildConstant() const {
+    static std::mutex building;
+    std::lock_guard<std::mutex> lock(building);
+    if (!built.load(std::memory_order_relaxed)) {
+      values.assign(width * (_order+1), 0.0);
+      values[0] = _value;
+      built.store(true, std::memory_order_release);
+    }
+  }
+
+  /**
+   * x^n with the same sequence of products as Power's squaring, so that
+   * constants agree bitwise with repeated multiplication
+   */
+  static double integerPower(double x, int n) {
+    if (n < 0)
+      return std::pow(x, n);
+    else if (n == 0)
+      return 1.0;
+
+    unsigned int bit = 1;
+    while ((unsigned int)n >= (bit << 1))
+      bit <<= 1;
+
+    double r = x;
+    for (bit >>= 1; bit > 0; bit >>= 1) {
+      r *= r;
+      if (n & bit)
+	r *= x;
+    }
+    return r;
+  }
+
   NPNumber NPNumber::plus(const NPNumber& o) const {
-    vector<double> c(values.size());
-    transform(values.begin(),values.end(),o.values.begin(),c.begin(), std::plus<double>());
-    return NPNumber(width, c);
+    if (o._constant)
+      return plus(o._value);
+    else if (_constant)
+      return o.plus(_value);
+
+    NPNumber res(*this, FieldVector::Uninitialized());
+    transform(values.begin(),values.end(),o.values.begin(),res.values.begin(), std::plus<double>());
+    return res;
   }
 
   NPNumber NPNumber::plus(const double o) const {
-    vector<double> c(values);
-    c[0] += o;
-    return NPNumber(width, c);
+    if (_constant)
+      return constantOf(_value + o);
+
+    NPNumber res(*this);
+    res.values[0] += o;
+    return res;
   }
 
   NPNumber NPNumber::minus(const double o) const {
-    vector<double> c(values);
-    c[0] -= o;
-    return NPNumber(width, c);
+    if (_constant)
+      return constantOf(_value - o);
+
+    NPNumber res(*this);
+    res.values[0] -= o;
+    return res;
   }
 
   NPNumber NPNumber::minus(const NPNumber& o) const {
-    vector<double> c(values.size());   
-    transform(values.begin(),values.end(),o.values.begin(),c.begin(), std::minus<double>());
-    return NPNumber(width, c);
+    if (o._constant)
+      return minus(o._value);
+    else if (_constant)
+      return o.times(-1.0).plus(_value);
+
+    NPNumber res(*this, FieldVector::Uninitialized());
+    transform(values.begin(),values.end(),o.values.begin(),res.values.begin(), std::minus<double>());
+    return res;
   }
 
   NPNumber NPNumber::times(const NPNumber& o) const {
-    vector<double> c(values.size());   
-    mult().apply(values, o.values, c, width);
-    return NPNumber(width, c);
+    if (o._constant)
+      return times(o._value);
+    else if (_constant)
+      return o.times(_value);
+
+    NPNumber res(*this, FieldVector::Uninitialized());
+    mult().apply(values.data(), o.values.data(), res.values.data(), width);
+    return res;
   }
 
   NPNumber NPNumber::times(const double f) const {
-    vector<double> c(values.size());   
-    for (unsigned int i = 0; i < c.size(); ++i)
-      c[i] = values[i] * f;
-    return NPNumber(width, c);
-  }
-
-  NPNumber NPNumber::pow(int n) const {
-    // create the power function value and derivatives
-    // [x^n, nx^(n-1), n(n-1)x^(n-2), ... ]
-    vector<double> f(_order + 2);
-
-    if (n >= 0) {
-      // strictly positive power
-      const int maxOrder = min(_order + 1, (unsigned int)n);
-      double xk = std::pow(values[0], n - maxOrder);
-      for (int i = maxOrder; i > 0; --i) {
-	f[i] = xk;
-	xk *= values[0];
-      }
-      f[0] = xk;
-    } else {
-      // strictly negative power
-      const double inv = 1.0 / values[0];
-      double xk = std::pow(inv, -n);
-      for (int i = 0; i <= _order + 1; ++i) {
-	f[i] = xk;
-	xk *= inv;
-      }
-    }
+    if (_constant)
+      return constantOf(_value * f);
+
+    NPNumber res(*this, FieldVector::Uninitialized());
+    for (unsigned int i = 0; i < values.size(); ++i)
+      res.values[i] = values[i] * f;
+    return res;
+  }
+
+  NPNumber NPNumber::pow(int n, PowerMethod method) const {
+    if (_constant)
+      return constantOf(integerPower(_value, n));
+
+    NPNumber newNum(params(), order());
+    Power::apply(n, values.data(), newNum.values.data(), _order, width, method);
+    return newNum;
+  }
+
+  NPNumber NPNumber::pow(double alpha) const {
+    if (_constant)
+      return constantOf(std::pow(_value, alpha));
+
+    NPNumber newNum(params(), order());
+    Elementary::pow(values.data(), newNum.values.data(), alpha, _order, width);
+    return newNum;
+  }
+
+  NPNumber NPNumber::pow(const NPNumber& e) const {
+    if (e._constant)
+      return pow(e._value);
+
+    NPNumber newNum(params(), order());
+    Elementary::pow(data().data(), e.values.data(), newNum.values.data(), _order, width);
+    return newNum;
+  }
+
+  NPNumber NPNumber::atan2(const NPNumber& x) const {
+    if (_constant && x._constant)
+      return constantOf(std::atan2(_value, x._value));
+
+    NPNumber newNum(params(), order());
+    Elementary::atan2(data().data(), x.data().data(), newNum.values.data(), _order, width);
+    return newNum;
+  }
+
+  NPNumber NPNumber::hypot(const NPNumber& o) const {
+    if (_constant && o._constant)
+      return constantOf(std::hypot(_value, o._value));
+
+    NPNumber newNum(params(), order());
+    Elementary::hypot(data().data(), o.data().data(), newNum.values.data(), _order, width);
+    return newNum;
+  }
+
+  NPNumber NPNumber::sqrt() const {
+    if (_constant)
+      return constantOf(std::sqrt(_value));
+
+    NPNumber newNum(params(), order());
+    Elementary::sqrt(values.data(), newNum.values.data(), _order, width);
+    return newNum;
+  }
+
+  NPNumber NPNumber::cbrt() const {
+    if (_constant)
+      return constantOf(std::cbrt(_value));
+
+    NPNumber newNum(params(), order());
+    Elementary::cbrt(values.data(), newNum.values.data(), _order, width);
+    return newNum;
+  }
+
+  NPNumber NPNumber::exp() const {
+    if (_constant)
+      return constantOf(std::exp(_value));
+
+    NPNumber newNum(params(), order());
+    Elementary::exp(values.data(), newNum.values.data(), _order, width);
+    return newNum;
+  }
 
-    double coefficient = n;
-    for (int i = 1; i <= _order + 1; ++i) {
-      f[i] *= coefficient;
-      coefficient *= n - i;
+  NPNumber NPNumber::log() const {
+    if (_constant)
+      return constantOf(std::log(_value));
+
+    NPNumber newNum(params(), order());
+    Elementary::log(values.data(), newNum.values.data(), _order, width);
+    return newNum;
+  }
+
+  NPNumber NPNumber::apply(unsigned int function) const {
+    return apply(FunctionRegistry::get(function));
+  }
+
+  NPNumber NPNumber::apply(const UnaryFunction& f) const {
+    if (_constant) {
+      double value;
+      f.derivatives(_value, 0, &value);
+      return constantOf(value);
     }
 
     NPNumber newNum(params(), order());
-    comp()->apply(f, values, newNum.values, width);
-    
+    f.apply(values.data(), newNum.values.data(), _order, width);
     return newNum;
   }
 
-  NPNumber NPNumber::operator*=(const NPNumber& o) {
-    vector<double> c(values);
-    mult().apply(c, o.values, values, width);
+  std::vector<NPNumber> NPNumber::compose(const std::vector<std::vector<double>>& derivatives) const {
+    const unsigned int m = derivatives.size();
+    vector<double> f;
+    f.reserve(m * (_order + 2));
+    for (const vector<double>& d : derivatives)
+      f.insert(f.end(), d.begin(), d.begin() + _order + 2);
+
+    const unsigned int size = data().size();
+    vector<double> target(m * size);
+    comp()->applyMany(f.data(), m, values.data(), target.data(), width);
+
+    std::vector<NPNumber> res;
+    res.reserve(m);
+    for (unsigned int i = 0; i < m; ++i) {
+      FieldVector v;
+      v.assign(target.data() + i*size, target.data() + (i+1)*size);
+      res.push_back(NPNumber(width, std::move(v)));
+    }
+    return res;
+  }
+
+  std::vector<NPNumber> NPNumber::apply(const std::vector<unsigned int>& functions) const {
+    std::vector<std::vector<double>> derivatives;
+    derivatives.reserve(functions.size());
+    for (unsigned int id : functions) {
+      vector<double> f(_order + 2);
+      FunctionRegistry::get(id).derivatives(der(0, 0), _order + 1, f.data());
+      derivatives.push_back(f);
+    }
+    return compose(derivatives);
+  }
+
+  std::pair<NPNumber, NPNumber> NPNumber::sincos() const {
+    if (_constant)
+      return std::make_pair(constantOf(std::sin(_value)), constantOf(std::cos(_value)));
+
+    std::pair<NPNumber, NPNumber> res(NPNumber(params(), order()), NPNumber(params(), order()));
+    Elementary::sincos(values.data(), res.first.values.data(), res.second.values.data(), _order, width);
+    return res;
+  }
+
+  std::pair<NPNumber, NPNumber> NPNumber::sinhcosh() const {
+    if (_constant)
+      return std::make_pair(constantOf(std::sinh(_value)), constantOf(std::cosh(_value)));
+
+    std::pair<NPNumber, NPNumber> res(NPNumber(params(), order()), NPNumber(params(), order()));
+    Elementary::sinhcosh(values.data(), res.first.values.data(), res.second.values.data(), _order, width);
+    return res;
+  }
+
+  NPNumber& NPNumber::operator*=(const NPNumber& o) {
+    if (o._constant)
+      return *this *= o._value;
+    else if (_constant)
+      return *this = o.times(_value);
+
+    mult().applyInPlace(values.data(), o.values.data(), values.data(), width);
+    return *this;
+  }
+
+  NPNumber& NPNumber::multiplyFrom(const NPNumber& o) {
+    if (o._constant)
+      return *this *= o._value;
+    else if (_constant)
+      return *this = o.times(_value);
+
+    mult().applyInPlace(o.values.data(), values.data(), values.data(), width);
     return *this;
   }
 
-  NPNumber NPNumber::operator*=(const double o) {
+  NPNumber& NPNumber::operator*=(const double o) {
+    if (_constant)
+      return *this = constantOf(_value * o);
+
     for (int i = 0; i < values.size(); i++)
       values[i] *= o;
     return *this;
   }
 
-  NPNumber NPNumber::operator+=(const double o) {
+  NPNumber& NPNumber::operator+=(const double o) {
+    if (_constant)
+      return *this = constantOf(_value + o);
+
     values[0] += o;
     return *this;
   }
 
-  NPNumber NPNumber::operator+=(const NPNumber& o) {
+  NPNumber& NPNumber::operator+=(const NPNumber& o) {
+    if (o._constant)
+      return *this += o._value;
+    else if (_constant)
+      return *this = o.plus(_value);
+
     for (int i = 0; i < values.size(); i++)
       values[i] += o.values[i];
     return *this;
   }  
 
+  NPNumber& NPNumber::operator-=(const double o) {
+    if (_constant)
+      return *this = constantOf(_value - o);
+
+    values[0] -= o;
+    return *this;
+  }
+
+  NPNumber& NPNumber::operator-=(const NPNumber& o) {
+    if (o._constant)
+      return *this -= o._value;
+    else if (_constant)
+      return *this = o.times(-1.0).plus(_value);
+
+    for (std::size_t i = 0; i < values.size(); i++)
+      values[i] -= o.values[i];
+    return *this;
+  }  
+
+  NPNumber& NPNumber::subtractFrom(const NPNumber& o) {
+    if (o._constant) {
+      if (_constant)
+	return *this = constantOf(o._value - _value);
+
+      for (std::size_t i = 0; i < values.size(); i++)
+	values[i] = -values[i];
+      values[0] += o._value;
+      return *this;
+    } else if (_constant)
+      return *this = o.minus(_value);
+
+    for (std::size_t i = 0; i < values.size(); i++)
+      values[i] = o.values[i] - values[i];
+    return *this;
+  }
+
   std::ostream& operator<<(std::ostream& out, const NPNumber& n) {
-    out << "npnumber{width=" << n.width << ", order=" << n.order() << ", values=" << n.values << "}";
+    out << "npnumber{width=" << n.width << ", order=" << n.order() << ", values=" << n.data() << "}";
     return out;
   }   
 }
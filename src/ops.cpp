@@ -18,8 +18,14 @@
  */
 
 #include <tnp/ops.h>
+#include <tnp/context.hpp>
 #include <tnp/ops/multiplication.hpp>
 #include <tnp/ops/composition.hpp>
+#include <tnp/ops/elementary.hpp>
+#include <tnp/ops/functions.hpp>
+#include <tnp/ops/power.hpp>
+#include <tnp/ops/layout.hpp>
+#include <tnp/alignednpnumber.hpp>
 
 #include <algorithm>
 #include <cmath>
@@ -27,13 +33,69 @@
 extern "C" {
   
   void op_prepare(int order) {
-    tnp::Multiplication::ensureExistance(order);
+    tnp_context_prepare(tnp_context_default(), order);
   }
   
+  int tnp_function_register(tnp_derivative_callback scalar, tnp_derivatives_callback batch, void* data) {
+    tnp::ops::DerivativeGenerator s = nullptr;
+    tnp::ops::BatchDerivativeGenerator b = nullptr;
+
+    if (scalar)
+      s = [scalar, data](double x, unsigned int k) { return scalar(x, k, data); };
+    if (batch)
+      b = [batch, data](double x, unsigned int n, double* f) { batch(x, n, f, data); };
+
+    const unsigned int id = tnp::ops::FunctionRegistry::add(s, b);
+    return id == tnp::ops::FunctionRegistry::INVALID ? -1 : (int) id;
+  }
+
   size_t tnp_number_payload_size(int params, int order) {
     return sizeof(double) * (params+1) * (order+1);
   }
   
+  int tnp_number_padded_stride(int params) {
+    return tnp::paddedStride(params + 1);
+  }
+
+  size_t tnp_number_padded_payload_size(int params, int order) {
+    return sizeof(double) * tnp_number_padded_stride(params) * (order+1);
+  }
+
+  void op_tnp_number_pad(int params, int order, double* padded, double* packed) {
+    const int stride = tnp_number_padded_stride(params);
+    memset(padded, 0, tnp_number_padded_payload_size(params, order));
+    tnp::NPNumberView(padded, params, order, stride).assign(tnp::ConstNPNumberView(packed, params, order));
+  }
+
+  void op_tnp_number_unpad(int params, int order, double* packed, double* padded) {
+    const int stride = tnp_number_padded_stride(params);
+    tnp::ConstNPNumberView(padded, params, order, stride).copyTo(packed);
+  }
+
+  void op_tnp_number_mult_padded(int params, int order, double* target, double* a, double* b) {
+    op_tnp_number_mult_padded_ctx(tnp_context_default(), params, order, target, a, b);
+  }
+
+  void op_tnp_number_mult_padded_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* b) {
+    ctx->multiplication(order).applyPadded(a, b, target, params + 1, tnp_number_padded_stride(params));
+  }
+  
+  void op_tnp_number_to_parameter_major(int params, int order, double* target, double* a) {
+    tnp::ops::Layout::toParameterMajor(a, target, order, params + 1);
+  }
+
+  void op_tnp_number_to_order_major(int params, int order, double* target, double* a) {
+    tnp::ops::Layout::toOrderMajor(a, target, order, params + 1);
+  }
+
+  void op_tnp_number_mult_parameter_major(int params, int order, double* target, double* a, double* b) {
+    op_tnp_number_mult_parameter_major_ctx(tnp_context_default(), params, order, target, a, b);
+  }
+
+  void op_tnp_number_mult_parameter_major_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* b) {
+    ctx->multiplication(order).applyTransposed(a, b, target, params + 1);
+  }
+
   void op_tnp_number_to_zero(int params, int order, double* a) {
     memset(a, 0, tnp_number_payload_size(params, order));
   }
@@ -71,11 +133,15 @@ extern "C" {
   void op_tnp_number_dadd(int params, int order, double* target, double* a, double b) {
     const size_t size = (params + 1) * (order + 1);
     std::copy(a, a + size, target);
-    a[0] += b;
+    target[0] += b;
   }
 
   void op_tnp_number_mult(int params, int order, double* target, double* a, double* b) {
-    tnp::Multiplication::cacheVector()[order].apply(a, b, target, params + 1);
+    op_tnp_number_mult_ctx(tnp_context_default(), params, order, target, a, b);
+  }
+
+  void op_tnp_number_mult_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* b) {
+    ctx->multiplication(order).apply(a, b, target, params + 1);
   }
 
   void op_tnp_number_dmult(int params, int order, double* target, double* a, double b) {
@@ -93,7 +159,7 @@ extern "C" {
   void op_tnp_number_dsub(int params, int order, double* target, double* a, double b) {
     const size_t size = (params + 1) * (order + 1);
     std::copy(a, a + size, target);
-    a[0] -= b;
+    target[0] -= b;
   }
 
   /*
@@ -102,36 +168,131 @@ extern "C" {
     double* double_ddiv(int params, int order, double* a, double b);
   */
   void op_tnp_number_pow(int params, int order, double* target, double* a, int n) {
-    // create the power function value and derivatives
-    // [x^n, nx^(n-1), n(n-1)x^(n-2), ... ]
-    double f[order + 2];
-
-    if (n >= 0) {
-      // strictly positive power
-      const int maxOrder = std::min(order + 1, n);
-      double xk = std::pow(a[0], n - maxOrder);
-      for (int i = maxOrder; i > 0; --i) {
-	f[i] = xk;
-	xk *= a[0];
-      }
-      f[0] = xk;
-    } else {
-      // strictly negative power
-      const double inv = 1.0 / a[0];
-      double xk = std::pow(inv, -n);
-      for (int i = 0; i <= order + 1; ++i) {
-	f[i] = xk;
-	xk *= inv;
-      }
-    }
+    op_tnp_number_pow_ctx(tnp_context_default(), params, order, target, a, n);
+  }
+
+  void op_tnp_number_pow_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, int n) {
+    ctx->ensure(order);
+    tnp::ops::Power::apply(n, a, target, order, params+1, ctx->powerMethod(),
+			   ctx->scratch(tnp::ops::Power::scratchSize(order, params+1)));
+  }
 
-    double coefficient = n;
-    for (int i = 1; i <= order + 1; ++i) {
-      f[i] *= coefficient;
-      coefficient *= n - i;
+  void op_pow_method(int method) {
+    tnp_context_pow_method(tnp_context_default(), method);
+  }
+
+  void op_tnp_number_powr(int params, int order, double* target, double* a, double power) {
+    op_tnp_number_powr_ctx(tnp_context_default(), params, order, target, a, power);
+  }
+
+  void op_tnp_number_powr_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double power) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::pow(a, target, power, order, params+1);
+  }
+
+  void op_tnp_number_npow(int params, int order, double* target, double* a, double* b) {
+    op_tnp_number_npow_ctx(tnp_context_default(), params, order, target, a, b);
+  }
+
+  void op_tnp_number_npow_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* b) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::pow(a, b, target, order, params+1,
+			      ctx->scratch(tnp::ops::Elementary::scratchSize(order, params+1)));
+  }
+
+  void op_tnp_number_atan2(int params, int order, double* target, double* y, double* x) {
+    op_tnp_number_atan2_ctx(tnp_context_default(), params, order, target, y, x);
+  }
+
+  void op_tnp_number_atan2_ctx(struct tnp_context* ctx, int params, int order, double* target, double* y, double* x) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::atan2(y, x, target, order, params+1,
+				ctx->scratch(tnp::ops::Elementary::scratchSize(order, params+1)));
+  }
+
+  void op_tnp_number_hypot(int params, int order, double* target, double* x, double* y) {
+    op_tnp_number_hypot_ctx(tnp_context_default(), params, order, target, x, y);
+  }
+
+  void op_tnp_number_hypot_ctx(struct tnp_context* ctx, int params, int order, double* target, double* x, double* y) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::hypot(x, y, target, order, params+1,
+				ctx->scratch(tnp::ops::Elementary::scratchSize(order, params+1)));
+  }
+
+  void op_tnp_number_sqrt(int params, int order, double* target, double* a) {
+    op_tnp_number_sqrt_ctx(tnp_context_default(), params, order, target, a);
+  }
+
+  void op_tnp_number_sqrt_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::sqrt(a, target, order, params+1);
+  }
+
+  void op_tnp_number_cbrt(int params, int order, double* target, double* a) {
+    op_tnp_number_cbrt_ctx(tnp_context_default(), params, order, target, a);
+  }
+
+  void op_tnp_number_cbrt_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::cbrt(a, target, order, params+1);
+  }
+
+  void op_tnp_number_apply(int params, int order, double* target, double* a, int function) {
+    op_tnp_number_apply_ctx(tnp_context_default(), params, order, target, a, function);
+  }
+
+  void op_tnp_number_apply_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, int function) {
+    if (function < 0 || !tnp::ops::FunctionRegistry::valid(function)) {
+      std::fill(target, target + (params+1) * (order+1), NAN);
+      return;
     }
+    ctx->ensure(order);
+    tnp::ops::FunctionRegistry::get(function).apply(a, target, order, params+1, ctx->scratch(order + 2));
+  }
+
+  void op_tnp_number_compose_many(int params, int order, double* target, double* a, double* f, int m) {
+    op_tnp_number_compose_many_ctx(tnp_context_default(), params, order, target, a, f, m);
+  }
+
+  void op_tnp_number_compose_many_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a, double* f, int m) {
+    ctx->composition(order).applyMany(f, m, a, target, params+1);
+  }
+
+  void op_tnp_number_exp(int params, int order, double* target, double* a) {
+    op_tnp_number_exp_ctx(tnp_context_default(), params, order, target, a);
+  }
+
+  void op_tnp_number_exp_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::exp(a, target, order, params+1);
+  }
+
+  void op_tnp_number_log(int params, int order, double* target, double* a) {
+    op_tnp_number_log_ctx(tnp_context_default(), params, order, target, a);
+  }
+
+  void op_tnp_number_log_ctx(struct tnp_context* ctx, int params, int order, double* target, double* a) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::log(a, target, order, params+1);
+  }
+
+  void op_tnp_number_sincos(int params, int order, double* sin, double* cos, double* a) {
+    op_tnp_number_sincos_ctx(tnp_context_default(), params, order, sin, cos, a);
+  }
+
+  void op_tnp_number_sincos_ctx(struct tnp_context* ctx, int params, int order, double* sin, double* cos, double* a) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::sincos(a, sin, cos, order, params+1);
+  }
+
+  void op_tnp_number_sinhcosh(int params, int order, double* sinh, double* cosh, double* a) {
+    op_tnp_number_sinhcosh_ctx(tnp_context_default(), params, order, sinh, cosh, a);
+  }
 
-    tnp::ops::CompositionCache::staticGetInstance(order)->apply(f, a, target, params+1);
+  void op_tnp_number_sinhcosh_ctx(struct tnp_context* ctx, int params, int order, double* sinh, double* cosh, double* a) {
+    ctx->ensure(order);
+    tnp::ops::Elementary::sinhcosh(a, sinh, cosh, order, params+1);
   }
 
 }
@@ -0,0 +1,360 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/paralleltape.hpp>
+
+#include <algorithm>
+#include <functional>
+
+namespace tnp {
+
+  namespace {
+    const unsigned int NONE = ~0u;
+  }
+
+  ParallelTapeEvaluator::ParallelTapeEvaluator(const Tape& tape, unsigned int threads, bool deterministic) :
+    tape(tape), width(tape.params() + 1), size(tape.size()), _deterministic(deterministic),
+    arena(tape.slots() * tape.size(), 0.0), _work(0.0), _criticalPath(0.0),
+    pending(new std::atomic<unsigned int>[tape.instructions().size()]),
+    done(new std::atomic<bool>[tape.instructions().size()]),
+    remaining(0), _steals(0), generation(0), busy(0), stop(false) {
+
+    Multiplication::ensureExistance(tape.order());
+    CompositionCache::staticGetInstance(tape.order());
+
+    if (threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int w = 0; w < threads; ++w) {
+      queues.emplace_back();
+      queues.back().scratch.resize(TapeEvaluator::scratchSize(tape.order(), width));
+    }
+
+    buildGraph();
+    if (_deterministic)
+      scheduleStatically();
+
+    for (unsigned int w = 1; w < threads; ++w)
+      pool.push_back(std::thread(&ParallelTapeEvaluator::loop, this, w));
+  }
+
+  ParallelTapeEvaluator::~ParallelTapeEvaluator() {
+    {
+      std::lock_guard<std::mutex> l(poolLock);
+      stop = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : pool)
+      t.join();
+  }
+
+  double ParallelTapeEvaluator::cost(const TapeInstruction& i, unsigned int order, unsigned int width) {
+    const double fields = (order + 1) * width;
+    const double product = (order + 1) * (order + 2) / 2.0 * (2*width - 1);
+
+    double c = fields;
+    switch (i.op) {
+    case TAPE_CONSTANT:
+    case TAPE_ADD:
+    case TAPE_SUB:
+    case TAPE_ADD_SCALAR:
+    case TAPE_SCALE:
+      c = fields;
+      break;
+    case TAPE_MUL:
+      c = product;
+      break;
+    case TAPE_POW_INT: {
+      // one or two products per bit of the exponent
+      unsigned int bits = 1;
+      for (unsigned int n = i.n < 0 ? -i.n : i.n; n > 1; n >>= 1)
+	++bits;
+      c = 2 * bits * product;
+      break;
+    }
+    case TAPE_POW_REAL:
+    case TAPE_SQRT:
+    case TAPE_CBRT:
+    case TAPE_EXP:
+    case TAPE_LOG:
+    case TAPE_SINCOS:
+    case TAPE_SINHCOSH:
+      c = 2 * product;
+      break;
+    case TAPE_POW:
+    case TAPE_ATAN2:
+    case TAPE_HYPOT:
+      c = 4 * product;
+      break;
+    case TAPE_APPLY:
+      c = CompositionCache::staticGetInstance(order)->cost(width);
+      break;
+    }
+    return std::max(1.0, c);
+  }
+
+  void ParallelTapeEvaluator::buildGraph() {
+    const std::vector<TapeInstruction>& all = tape.instructions();
+    const unsigned int n = all.size();
+    successors.resize(n);
+    predecessors.resize(n);
+    costs.resize(n);
+    priorities.resize(n);
+
+    std::vector<unsigned int> lastWriter(tape.slots(), NONE);
+    std::vector<std::vector<unsigned int> > readers(tape.slots());
+
+    for (unsigned int k = 0; k < n; ++k) {
+      const TapeInstruction& i = all[k];
+      const unsigned int operands = i.operands();
+
+      unsigned int reads[2];
+      unsigned int nReads = 0;
+      if (operands > 0)
+	reads[nReads++] = i.a;
+      if (operands > 1)
+	reads[nReads++] = i.b;
+
+      unsigned int writes[2] = { i.target, i.b };
+      const unsigned int nWrites = i.twoResults() ? 2 : 1;
+
+      std::vector<unsigned int>& deps = predecessors[k];
+      for (unsigned int r = 0; r < nReads; ++r)
+	if (lastWriter[reads[r]] != NONE)
+	  deps.push_back(lastWriter[reads[r]]);
+      for (unsigned int w = 0; w < nWrites; ++w) {
+	if (lastWriter[writes[w]] != NONE)
+	  deps.push_back(lastWriter[writes[w]]);
+	deps.insert(deps.end(), readers[writes[w]].begin(), readers[writes[w]].end());
+      }
+      std::sort(deps.begin(), deps.end());
+      deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+      for (unsigned int d : deps)
+	successors[d].push_back(k);
+
+      for (unsigned int r = 0; r < nReads; ++r)
+	readers[reads[r]].push_back(k);
+      for (unsigned int w = 0; w < nWrites; ++w) {
+	lastWriter[writes[w]] = k;
+	readers[writes[w]].clear();
+      }
+
+      costs[k] = cost(i, tape.order(), width);
+      _work += costs[k];
+    }
+
+    for (unsigned int k = n; k-- > 0;) {
+      double longest = 0.0;
+      for (unsigned int s : successors[k])
+	longest = std::max(longest, priorities[s]);
+      priorities[k] = costs[k] + longest;
+      _criticalPath = std::max(_criticalPath, priorities[k]);
+    }
+  }
+
+  bool ParallelTapeEvaluator::higher(unsigned int a, unsigned int b) const {
+    return priorities[a] > priorities[b] || (priorities[a] == priorities[b] && a < b);
+  }
+
+  void ParallelTapeEvaluator::scheduleStatically() {
+    const unsigned int n = tape.instructions().size();
+    const unsigned int threads = queues.size();
+    assigned.assign(threads, std::vector<unsigned int>());
+
+    std::vector<double> threadFree(threads, 0.0);
+    std::vector<double> finish(n, 0.0);
+    std::vector<unsigned int> missing(n);
+    std::vector<unsigned int> ready;
+
+    /* lower(a, b): a is less urgent than b, so the heap yields the most urgent instruction */
+    const std::function<bool(unsigned int, unsigned int)> lower =
+      [this](unsigned int a, unsigned int b) { return higher(b, a); };
+
+    for (unsigned int k = 0; k < n; ++k) {
+      missing[k] = predecessors[k].size();
+      if (missing[k] == 0)
+	ready.push_back(k);
+    }
+    std::make_heap(ready.begin(), ready.end(), lower);
+
+    while (!ready.empty()) {
+      std::pop_heap(ready.begin(), ready.end(), lower);
+      const unsigned int k = ready.back();
+      ready.pop_back();
+
+      double available = 0.0;
+      for (unsigned int p : predecessors[k])
+	available = std::max(available, finish[p]);
+
+      /* the thread on which k can start first */
+      unsigned int best = 0;
+      for (unsigned int w = 1; w < threads; ++w)
+	if (std::max(threadFree[w], available) < std::max(threadFree[best], available))
+	  best = w;
+
+      finish[k] = std::max(threadFree[best], available) + costs[k];
+      threadFree[best] = finish[k];
+      assigned[best].push_back(k);
+
+      for (unsigned int s : successors[k]) {
+	if (--missing[s] == 0) {
+	  ready.push_back(s);
+	  std::push_heap(ready.begin(), ready.end(), lower);
+	}
+      }
+    }
+  }
+
+  void ParallelTapeEvaluator::push(unsigned int worker, unsigned int instruction) {
+    Queue& q = queues[worker];
+    std::lock_guard<std::mutex> l(q.lock);
+    q.ready.push_back(instruction);
+    std::push_heap(q.ready.begin(), q.ready.end(),
+		   [this](unsigned int a, unsigned int b) { return higher(b, a); });
+  }
+
+  bool ParallelTapeEvaluator::pop(unsigned int worker, unsigned int& instruction) {
+    Queue& q = queues[worker];
+    std::lock_guard<std::mutex> l(q.lock);
+    if (q.ready.empty())
+      return false;
+    std::pop_heap(q.ready.begin(), q.ready.end(),
+		  [this](unsigned int a, unsigned int b) { return higher(b, a); });
+    instruction = q.ready.back();
+    q.ready.pop_back();
+    return true;
+  }
+
+  bool ParallelTapeEvaluator::steal(unsigned int worker, unsigned int& instruction) {
+    const unsigned int threads = queues.size();
+    for (unsigned int offset = 1; offset < threads; ++offset) {
+      if (pop((worker + offset) % threads, instruction)) {
+	_steals++;
+	return true;
+      }
+    }
+    return false;
+  }
+
+  void ParallelTapeEvaluator::work(unsigned int worker) {
+    const std::vector<TapeInstruction>& all = tape.instructions();
+    double* scratch = queues[worker].scratch.data();
+
+    if (_deterministic) {
+      for (unsigned int k : assigned[worker]) {
+	for (unsigned int p : predecessors[k])
+	  while (!done[p].load(std::memory_order_acquire))
+	    std::this_thread::yield();
+	TapeEvaluator::execute(all[k], arena.data(), tape.order(), width, scratch);
+	done[k].store(true, std::memory_order_release);
+      }
+      return;
+    }
+
+    while (remaining.load(std::memory_order_acquire) > 0) {
+      unsigned int k;
+      if (pop(worker, k) || steal(worker, k)) {
+	TapeEvaluator::execute(all[k], arena.data(), tape.order(), width, scratch);
+	for (unsigned int s : successors[k])
+	  if (pending[s].fetch_sub(1, std::memory_order_acq_rel) == 1)
+	    push(worker, s);
+	remaining.fetch_sub(1, std::memory_order_acq_rel);
+      } else {
+	std::this_thread::yield();
+      }
+    }
+  }
+
+  void ParallelTapeEvaluator::loop(unsigned int worker) {
+    unsigned long seen = 0;
+    while (true) {
+      {
+	std::unique_lock<std::mutex> l(poolLock);
+	wake.wait(l, [this, seen]() { return stop || generation != seen; });
+	if (stop)
+	  return;
+	seen = generation;
+      }
+
+      work(worker);
+
+      {
+	std::lock_guard<std::mutex> l(poolLock);
+	if (--busy == 0)
+	  finished.notify_one();
+      }
+    }
+  }
+
+  void ParallelTapeEvaluator::run() {
+    const std::vector<TapeInstruction>& all = tape.instructions();
+    const unsigned int n = all.size();
+
+    if (pool.empty()) {
+      for (const TapeInstruction& i : all)
+	TapeEvaluator::execute(i, arena.data(), tape.order(), width, queues[0].scratch.data());
+      return;
+    }
+
+    for (unsigned int k = 0; k < n; ++k) {
+      pending[k].store(predecessors[k].size(), std::memory_order_relaxed);
+      done[k].store(false, std::memory_order_relaxed);
+    }
+    remaining.store(n, std::memory_order_relaxed);
+
+    if (!_deterministic) {
+      std::vector<unsigned int> roots;
+      for (unsigned int k = 0; k < n; ++k)
+	if (predecessors[k].empty())
+	  roots.push_back(k);
+      std::sort(roots.begin(), roots.end(),
+		[this](unsigned int a, unsigned int b) { return higher(a, b); });
+      for (unsigned int r = 0; r < roots.size(); ++r)
+	push(r % queues.size(), roots[r]);
+    }
+
+    {
+      std::lock_guard<std::mutex> l(poolLock);
+      ++generation;
+      busy = pool.size();
+    }
+    wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> l(poolLock);
+    finished.wait(l, [this]() { return busy == 0; });
+  }
+
+  std::vector<NPNumber> ParallelTapeEvaluator::operator()(const std::vector<NPNumber>& inputs) {
+    std::vector<NPNumber> res;
+    if (!tape.accepts(inputs))
+      return res;
+
+    for (unsigned int i = 0; i < inputs.size(); ++i)
+      input(i).assign(inputs[i]);
+
+    run();
+
+    res.reserve(tape.outputs().size());
+    for (unsigned int i = 0; i < tape.outputs().size(); ++i)
+      res.push_back(output(i).toNPNumber());
+    return res;
+  }
+}
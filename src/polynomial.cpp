@@ -27,7 +27,7 @@ namespace tnp {
   using namespace boost;
 
   long SumOfProducts::lookups = 0; 
-  long SumOfProducts::evals = 0; 
+  std::atomic<long> SumOfProducts::evals(0);
   const pretty_print::delimiters_values<char> AddDelims::values = { "", " + ", "" };
 
   void addTerm(set<Term>& set, const Term& t) {
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/pool.hpp>
+
+#include <algorithm>
+
+namespace tnp {
+
+  namespace {
+    /* trivially destructible, so they can still be used after the pool of the thread is gone */
+    thread_local bool destroyed = false;
+    thread_local Pool::Statistics localStatistics = { 0, 0, 0, 0 };
+  }
+
+  Pool::Pool() : stats(&ownStatistics) {
+    std::fill(freeLists, freeLists + CLASSES, (Block*) 0);
+    ownStatistics.allocations = 0;
+    ownStatistics.systemAllocations = 0;
+    ownStatistics.deallocations = 0;
+    ownStatistics.systemDeallocations = 0;
+  }
+
+  Pool::Pool(Statistics& counters) : stats(&counters) {
+    std::fill(freeLists, freeLists + CLASSES, (Block*) 0);
+  }
+
+  Pool::~Pool() {
+    release();
+    /* only the end of the pool of the thread sends the numbers of the thread to the system allocator */
+    if (stats == &localStatistics)
+      destroyed = true;
+  }
+
+  Pool& Pool::local() {
+    static thread_local Pool pool(localStatistics);
+    return pool;
+  }
+
+  void* Pool::acquire(std::size_t bytes) {
+    if (destroyed) {
+      localStatistics.allocations++;
+      localStatistics.systemAllocations++;
+      return ::operator new(bytes);
+    }
+    return local().allocate(bytes);
+  }
+
+  void Pool::recycle(void* p, std::size_t bytes) {
+    if (destroyed) {
+      if (!p)
+	return;
+      localStatistics.deallocations++;
+      localStatistics.systemDeallocations++;
+      ::operator delete(p);
+    } else
+      local().deallocate(p, bytes);
+  }
+
+  void* Pool::allocate(std::size_t bytes) {
+    stats->allocations++;
+    const std::size_t c = sizeClass(bytes);
+
+    if (c >= CLASSES || c == 0) {
+      stats->systemAllocations++;
+      return ::operator new(bytes);
+    }
+
+    Block* b = freeLists[c];
+    if (b && enabled()) {
+      freeLists[c] = b->next;
+      return b;
+    }
+
+    stats->systemAllocations++;
+    return ::operator new(c * CLASS_BYTES);
+  }
+
+  void Pool::deallocate(void* p, std::size_t bytes) {
+    if (!p)
+      return;
+
+    stats->deallocations++;
+    const std::size_t c = sizeClass(bytes);
+
+    if (c >= CLASSES || c == 0 || !enabled()) {
+      stats->systemDeallocations++;
+      ::operator delete(p);
+      return;
+    }
+
+    Block* b = static_cast<Block*>(p);
+    b->next = freeLists[c];
+    freeLists[c] = b;
+  }
+
+  void Pool::release() {
+    for (std::size_t c = 0; c < CLASSES; ++c) {
+      while (freeLists[c]) {
+	Block* b = freeLists[c];
+	freeLists[c] = b->next;
+	stats->systemDeallocations++;
+	::operator delete(b);
+      }
+    }
+  }
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/ops/power.hpp>
+#include <tnp/ops/multiplication.hpp>
+#include <tnp/ops/composition.hpp>
+#include <tnp/ops/elementary.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tnp {
+  namespace ops {
+
+    using namespace std;
+
+    /*
+     * Cost weights, fitted to the timings of the testManyPowersByMethod sweep.
+     * Every kernel pays a fixed overhead per call, a cost per term of its
+     * row sums and a cost per term and parameter column. Multiplication
+     * walks the parameter columns with stride width, so its per-parameter
+     * weight is much higher than that of the recurrence.
+     */
+    static const double CALL_COST = 40.0;
+    static const double SQUARING_TERM = 0.5;
+    static const double SQUARING_PARAM_TERM = 1.4;
+    static const double RECURRENCE_TERM = 2.3;
+    static const double RECURRENCE_PARAM_TERM = 0.25;
+    static const double COMPOSITION_PRODUCT = 0.5;
+
+    double Power::squaringCost(int n, unsigned int order, unsigned int width) {
+      // left-to-right binary exponentiation: one squaring per bit, one product per further set bit
+      unsigned int products = 0;
+      for (unsigned int e = n; e > 1; e >>= 1)
+	products += 1 + (e & 1);
+
+      const double terms = (order + 1) * (order + 2) / 2.0;
+      return CALL_COST + products * terms * (SQUARING_TERM + SQUARING_PARAM_TERM * (width - 1));
+    }
+
+    double Power::recurrenceCost(unsigned int order, unsigned int width, unsigned int degree) {
+      // row n sums min(n, degree) terms in accumulateRow and min(n-1, degree) terms in quotientRow
+      double terms = 0;
+      for (unsigned int n = 1; n <= order; ++n)
+	terms += min(n, degree) + min(n - 1, degree);
+      return CALL_COST + terms * (RECURRENCE_TERM + RECURRENCE_PARAM_TERM * (width - 1));
+    }
+
+    double Power::compositionCost(unsigned int order, unsigned int width, unsigned int degree) {
+      // the affine closed form needs a handful of products per field
+      if (degree <= 1)
+	return CALL_COST + COMPOSITION_PRODUCT * 3 * (order + 1) * width;
+      return CALL_COST + COMPOSITION_PRODUCT * CompositionCache::staticGetInstance(order)->cost(width);
+    }
+
+    PowerMethod Power::choose(int n, const double* a, unsigned int order, unsigned int width) {
+      const unsigned int degree = Composition::degree(a, order, width);
+
+      PowerMethod best = POW_COMPOSITION;
+      double cost = compositionCost(order, width, degree);
+
+      if (a[0] != 0.0 && recurrenceCost(order, width, degree) < cost) {
+	best = POW_RECURRENCE;
+	cost = recurrenceCost(order, width, degree);
+      }
+
+      if (n >= 2 && squaringCost(n, order, width) <= cost)
+	best = POW_SQUARING;
+
+      return best;
+    }
+
+    void Power::apply(int n, const double* a, double* target, unsigned int order, unsigned int width,
+		      PowerMethod m, double* scratch) {
+      const unsigned int size = width * (order + 1);
+
+      if (n == 0) {
+	fill(target, target + size, 0.0);
+	target[0] = 1.0;
+	return;
+      } else if (n == 1) {
+	copy(a, a + size, target);
+	return;
+      }
+
+      if (m == POW_AUTOMATIC || (m == POW_SQUARING && n < 2) || (m == POW_RECURRENCE && a[0] == 0.0))
+	m = choose(n, a, order, width);
+
+      switch (m) {
+      case POW_SQUARING:
+	squaring(n, a, target, order, width, scratch);
+	break;
+      case POW_RECURRENCE:
+	Elementary::pow(a, target, n, order, width);
+	break;
+      default:
+	composition(n, a, target, order, width, Composition::degree(a, order, width), scratch);
+      }
+    }
+
+    void Power::squaring(int n, const double* a, double* target, unsigned int order, unsigned int width,
+			 double* scratch) {
+      const Multiplication& mult = Multiplication::ensureExistance(order);
+      const unsigned int size = width * (order + 1);
+
+      unsigned int bit = 1;
+      while ((unsigned int)n >= (bit << 1))
+	bit <<= 1;
+
+      // Multiplication must not write into its arguments, so alternate between two buffers
+      vector<double> own(scratch ? 0 : 2 * size);
+      double* r = scratch ? scratch : own.data();
+      double* s = r + size;
+      copy(a, a + size, r);
+
+      for (bit >>= 1; bit > 0; bit >>= 1) {
+	mult.apply(r, r, s, width);
+	swap(r, s);
+	if (n & bit) {
+	  mult.apply(r, a, s, width);
+	  swap(r, s);
+	}
+      }
+
+      copy(r, r + size, target);
+    }
+
+    void Power::composition(int n, const double* a, double* target, unsigned int order, unsigned int width,
+			    unsigned int degree, double* scratch) {
+      // create the power function value and derivatives
+      // [x^n, nx^(n-1), n(n-1)x^(n-2), ... ]
+      vector<double> own(scratch ? 0 : order + 2);
+      double* f = scratch ? scratch : own.data();
+
+      if (n >= 0) {
+	// strictly positive power
+	const int maxOrder = min(order + 1, (unsigned int)n);
+	// the higher derivatives vanish, scratch may hold anything there
+	fill(f + maxOrder + 1, f + order + 2, 0.0);
+	double xk = std::pow(a[0], n - maxOrder);
+	for (int i = maxOrder; i > 0; --i) {
+	  f[i] = xk;
+	  xk *= a[0];
+	}
+	f[0] = xk;
+      } else {
+	// strictly negative power
+	const double inv = 1.0 / a[0];
+	double xk = std::pow(inv, -n);
+	for (int i = 0; i <= (int) order + 1; ++i) {
+	  f[i] = xk;
+	  xk *= inv;
+	}
+      }
+
+      double coefficient = n;
+      for (int i = 1; i <= (int) order + 1; ++i) {
+	f[i] *= coefficient;
+	coefficient *= n - i;
+      }
+
+      CompositionCache::staticGetInstance(order)->apply(f, a, target, width, degree);
+    }
+  }
+}
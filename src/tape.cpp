@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/tape.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace tnp {
+
+  unsigned int TapeInstruction::operands() const {
+    switch (op) {
+    case TAPE_CONSTANT:
+      return 0;
+    case TAPE_ADD:
+    case TAPE_SUB:
+    case TAPE_MUL:
+    case TAPE_POW:
+    case TAPE_ATAN2:
+    case TAPE_HYPOT:
+      return 2;
+    default:
+      return 1;
+    }
+  }
+
+  static TapeInstruction instruction(TapeOp op, unsigned int target, unsigned int a, unsigned int b,
+				     int n, double scalar) {
+    TapeInstruction i;
+    i.op = op;
+    i.target = target;
+    i.a = a;
+    i.b = b;
+    i.n = n;
+    i.scalar = scalar;
+    return i;
+  }
+
+  TapeNumber TapeNumber::unary(TapeOp op, int n, double scalar) const {
+    const unsigned int target = tape->allocate();
+    tape->record(instruction(op, target, _slot, 0, n, scalar));
+    return TapeNumber(tape, target);
+  }
+
+  TapeNumber TapeNumber::binary(TapeOp op, const TapeNumber& o) const {
+    if (o.tape != tape)
+      return tape->constant(NAN);
+
+    const unsigned int target = tape->allocate();
+    tape->record(instruction(op, target, _slot, o._slot, 0, 0.0));
+    return TapeNumber(tape, target);
+  }
+
+  TapeNumber TapeNumber::apply(unsigned int function) const {
+    if (!FunctionRegistry::valid(function))
+      return tape->constant(NAN);
+    return unary(TAPE_APPLY, function, 0.0);
+  }
+
+  std::pair<TapeNumber, TapeNumber> TapeNumber::twoResults(TapeOp op) const {
+    const unsigned int first = tape->allocate();
+    const unsigned int second = tape->allocate();
+    tape->record(instruction(op, first, _slot, second, 0, 0.0));
+    return std::make_pair(TapeNumber(tape, first), TapeNumber(tape, second));
+  }
+
+  TapeNumber Tape::input() {
+    const unsigned int s = allocate();
+    _inputs.push_back(s);
+    return TapeNumber(this, s);
+  }
+
+  TapeNumber Tape::constant(double value) {
+    const unsigned int s = allocate();
+    record(instruction(TAPE_CONSTANT, s, 0, 0, 0, value));
+    return TapeNumber(this, s);
+  }
+
+  void Tape::output(const TapeNumber& n) {
+    _outputs.push_back(n.tape == this ? n.slot() : constant(NAN).slot());
+  }
+
+  TapeEvaluator::TapeEvaluator(const Tape& tape) :
+    tape(tape), width(tape.params() + 1), size(tape.size()),
+    arena(tape.slots() * tape.size(), 0.0),
+    scratch(scratchSize(tape.order(), tape.params() + 1)) {
+    Multiplication::ensureExistance(tape.order());
+    CompositionCache::staticGetInstance(tape.order());
+  }
+
+  unsigned int TapeEvaluator::scratchSize(unsigned int order, unsigned int width) {
+    return std::max(std::max(Elementary::scratchSize(order, width), Power::scratchSize(order, width)), order + 2);
+  }
+
+  void TapeEvaluator::run() {
+    for (const TapeInstruction& i : tape.instructions())
+      execute(i, arena.data(), tape.order(), width, scratch.data());
+  }
+
+  void TapeEvaluator::execute(const TapeInstruction& i, double* arena, unsigned int order, unsigned int width,
+			      double* s) {
+    const unsigned int size = (order + 1) * width;
+    double* t = arena + i.target*size;
+    const double* a = arena + i.a*size;
+    double* b = arena + i.b*size;
+
+    switch (i.op) {
+    case TAPE_CONSTANT:
+      std::fill(t, t + size, 0.0);
+      t[0] = i.scalar;
+      break;
+    case TAPE_ADD:
+      for (unsigned int k = 0; k < size; ++k)
+	t[k] = a[k] + b[k];
+      break;
+    case TAPE_SUB:
+      for (unsigned int k = 0; k < size; ++k)
+	t[k] = a[k] - b[k];
+      break;
+    case TAPE_MUL:
+      Multiplication::cacheVector()[order].apply(a, b, t, width);
+      break;
+    case TAPE_ADD_SCALAR:
+      std::copy(a, a + size, t);
+      t[0] += i.scalar;
+      break;
+    case TAPE_SCALE:
+      for (unsigned int k = 0; k < size; ++k)
+	t[k] = a[k] * i.scalar;
+      break;
+    case TAPE_POW_INT:
+      Power::apply(i.n, a, t, order, width, Power::method(), s);
+      break;
+    case TAPE_POW_REAL:
+      Elementary::pow(a, t, i.scalar, order, width);
+      break;
+    case TAPE_POW:
+      Elementary::pow(a, b, t, order, width, s);
+      break;
+    case TAPE_ATAN2:
+      Elementary::atan2(a, b, t, order, width, s);
+      break;
+    case TAPE_HYPOT:
+      Elementary::hypot(a, b, t, order, width, s);
+      break;
+    case TAPE_SQRT:
+      Elementary::sqrt(a, t, order, width);
+      break;
+    case TAPE_CBRT:
+      Elementary::cbrt(a, t, order, width);
+      break;
+    case TAPE_EXP:
+      Elementary::exp(a, t, order, width);
+      break;
+    case TAPE_LOG:
+      Elementary::log(a, t, order, width);
+      break;
+    case TAPE_APPLY:
+      FunctionRegistry::get(i.n).apply(a, t, order, width, s);
+      break;
+    case TAPE_SINCOS:
+      Elementary::sincos(a, t, b, order, width);
+      break;
+    case TAPE_SINHCOSH:
+      Elementary::sinhcosh(a, t, b, order, width);
+      break;
+    }
+  }
+
+  bool Tape::accepts(const std::vector<NPNumber>& numbers) const {
+    if (numbers.size() != _inputs.size())
+      return false;
+    for (const NPNumber& n : numbers)
+      if (n.params() != _params || n.order() != _order)
+	return false;
+    return true;
+  }
+
+  std::vector<NPNumber> TapeEvaluator::operator()(const std::vector<NPNumber>& inputs) {
+    std::vector<NPNumber> res;
+    if (!tape.accepts(inputs))
+      return res;
+
+    for (unsigned int i = 0; i < inputs.size(); ++i)
+      input(i).assign(inputs[i]);
+
+    run();
+
+    res.reserve(tape.outputs().size());
+    for (unsigned int i = 0; i < tape.outputs().size(); ++i)
+      res.push_back(output(i).toNPNumber());
+    return res;
+  }
+}
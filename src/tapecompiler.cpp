@@ -0,0 +1,552 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/tapecompiler.hpp>
+
+#include <map>
+#include <mutex>
+#include <cmath>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <fstream>
+#include <vector>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+
+#ifndef TNP_TAPE_COMPILER
+#define TNP_TAPE_COMPILER "cc"
+#endif
+
+namespace tnp {
+
+  namespace {
+    const std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+    const std::uint64_t FNV_PRIME = 1099511628211ull;
+
+    std::uint64_t fnv(std::uint64_t h, const void* data, std::size_t n) {
+      const unsigned char* bytes = static_cast<const unsigned char*>(data);
+      for (std::size_t k = 0; k < n; ++k) {
+	h ^= bytes[k];
+	h *= FNV_PRIME;
+      }
+      return h;
+    }
+
+    template<class T> std::uint64_t fnv(std::uint64_t h, const T& value) {
+      return fnv(h, &value, sizeof(value));
+    }
+
+    /**
+     * a C literal with the exact bits of value
+     */
+    std::string literal(double value) {
+      char buffer[64];
+      if (std::isfinite(value)) {
+	std::snprintf(buffer, sizeof(buffer), "%a", value);
+      } else {
+	std::uint64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	std::snprintf(buffer, sizeof(buffer), "tape_bits(0x%llxull)", (unsigned long long) bits);
+      }
+      return buffer;
+    }
+
+    std::string slot(unsigned int s, unsigned int size) {
+      std::ostringstream out;
+      out << "x + " << s * size;
+      return out.str();
+    }
+
+    /**
+     * target = a * b, every row unrolled over its terms, see FixedMultiplication::apply()
+     */
+    void emitProduct(std::ostream& out, unsigned int order, unsigned int width) {
+      out << "static inline void tape_mul(const double* restrict a, const double* restrict b, double* restrict t) {\n"
+	  << "  double d;\n";
+      if (width > 1)
+	out << "  unsigned int j;\n";
+      for (unsigned int n = 0; n <= order; ++n) {
+	const std::vector<double>& binomial = Multiplication::cacheVector()[n].binomials();
+
+	out << "  d = 0.0;\n";
+	for (unsigned int k = 0; k <= n; ++k)
+	  out << "  d += " << literal(binomial[k]) << " * a[" << (n - k)*width << "] * b[" << k*width << "];\n";
+	out << "  t[" << n*width << "] = d;\n";
+
+	if (width > 1) {
+	  out << "  for (j = 1; j < " << width << "; ++j) {\n"
+	      << "    d = 0.0;\n";
+	  for (unsigned int k = 0; k <= n; ++k) {
+	    const std::string c = literal(binomial[k]);
+	    out << "    d += " << c << " * a[" << (n - k)*width << " + j] * b[" << k*width << "];\n"
+		<< "    d += " << c << " * a[" << (n - k)*width << "] * b[" << k*width << " + j];\n";
+	  }
+	  out << "    t[" << n*width << " + j] = d;\n"
+	      << "  }\n";
+	}
+      }
+      out << "}\n\n";
+    }
+
+    /**
+     * the model and the features of the processor, objects built with -march=native
+     * may not run on another one that shares the cache directory
+     */
+    const std::string& hostProcessor() {
+      static const std::string processor = []() {
+	static const char* const keys[] = { "vendor_id", "cpu family", "model", "model name", "flags",
+					    "CPU implementer", "CPU architecture", "CPU variant", "CPU part",
+					    "Features", "isa" };
+	std::string id;
+	struct utsname u;
+	if (uname(&u) == 0)
+	  id = u.machine;
+
+	std::ifstream in("/proc/cpuinfo");
+	std::string line;
+	/* the first processor block is enough, all cores run the same code */
+	while (std::getline(in, line) && !line.empty()) {
+	  const std::string key = line.substr(0, line.find_first_of("\t:"));
+	  for (const char* k : keys)
+	    if (key == k)
+	      id += "\n" + line;
+	}
+	return id;
+      }();
+      return processor;
+    }
+
+    std::string hex(std::uint64_t h) {
+      char buffer[17];
+      std::snprintf(buffer, sizeof(buffer), "%016llx", (unsigned long long) h);
+      return buffer;
+    }
+
+    /**
+     * opens a regular file of the user without following links, -1 otherwise
+     */
+    int openOwn(const std::string& path) {
+      const int fd = open(path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+      struct stat s;
+      if (fd >= 0 && (fstat(fd, &s) != 0 || !S_ISREG(s.st_mode) || s.st_uid != getuid())) {
+	close(fd);
+	return -1;
+      }
+      return fd;
+    }
+
+    bool readAll(int fd, std::string& content) {
+      content.clear();
+      char buffer[4096];
+      ssize_t n;
+      while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+	content.append(buffer, n);
+      return n == 0;
+    }
+
+    bool readFile(const std::string& path, std::string& content) {
+      const int fd = openOwn(path);
+      if (fd < 0)
+	return false;
+      const bool ok = readAll(fd, content);
+      close(fd);
+      return ok;
+    }
+
+    /**
+     * writes content to a new file made from a mkstemps() pattern ending in suffix,
+     * path receives its name
+     */
+    bool writeTemporary(const std::string& pattern, const std::string& suffix,
+			const std::string& content, std::string& path) {
+      std::vector<char> name(pattern.begin(), pattern.end());
+      name.push_back('\0');
+      const int fd = mkstemps(name.data(), suffix.size());
+      if (fd < 0)
+	return false;
+      path = name.data();
+
+      std::size_t written = 0;
+      while (written < content.size()) {
+	const ssize_t n = write(fd, content.data() + written, content.size() - written);
+	if (n <= 0)
+	  break;
+	written += n;
+      }
+      if (close(fd) != 0 || written < content.size()) {
+	std::remove(path.c_str());
+	return false;
+      }
+      return true;
+    }
+
+    /**
+     * creates a directory (and a missing parent) and checks that it is a directory of the user
+     * that nobody else can access, not a symbolic link
+     */
+    bool privateDirectory(const std::string& path) {
+      if (mkdir(path.c_str(), 0700) != 0) {
+	if (errno == ENOENT) {
+	  const std::string::size_type slash = path.rfind('/');
+	  if (slash == std::string::npos || slash == 0)
+	    return false;
+	  if (mkdir(path.substr(0, slash).c_str(), 0700) != 0 && errno != EEXIST)
+	    return false;
+	  if (mkdir(path.c_str(), 0700) != 0 && errno != EEXIST)
+	    return false;
+	} else if (errno != EEXIST) {
+	  return false;
+	}
+      }
+      struct stat s;
+      return lstat(path.c_str(), &s) == 0 && S_ISDIR(s.st_mode) && s.st_uid == getuid() &&
+	(s.st_mode & 0777) == 0700;
+    }
+
+    /**
+     * the hash stored next to a shared object
+     */
+    std::string checksum(const std::string& object) {
+      return hex(fnv(FNV_OFFSET, object.data(), object.size()));
+    }
+
+    /**
+     * opens a shared object of the user whose content has the given checksum, -1 otherwise
+     */
+    int openVerified(const std::string& path, const std::string& sum) {
+      const int fd = openOwn(path);
+      std::string object;
+      if (fd >= 0 && !(readAll(fd, object) && checksum(object) == sum)) {
+	close(fd);
+	return -1;
+      }
+      return fd;
+    }
+
+    /**
+     * loads the object at path if it is still the verified file behind fd
+     */
+    void* openLibrary(int fd, const std::string& path) {
+      void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+      struct stat verified, loaded;
+      if (handle && (fstat(fd, &verified) != 0 || stat(path.c_str(), &loaded) != 0 ||
+		     verified.st_dev != loaded.st_dev || verified.st_ino != loaded.st_ino)) {
+	dlclose(handle);
+	return 0;
+      }
+      return handle;
+    }
+
+    std::string quote(const std::string& s) {
+      std::string res = "'";
+      for (char c : s) {
+	if (c == '\'')
+	  res += "'\\''";
+	else
+	  res += c;
+      }
+      return res + "'";
+    }
+
+    struct Loaded {
+      std::string source;
+      std::weak_ptr<void> library;
+    };
+
+    /* the shared objects loaded by this process, by key */
+    std::map<std::uint64_t, Loaded>& loaded() {
+      static std::map<std::uint64_t, Loaded> l;
+      return l;
+    }
+
+    std::mutex& loadLock() {
+      static std::mutex m;
+      return m;
+    }
+
+    std::string environment(const char* name, const std::string& fallback) {
+      const char* value = std::getenv(name);
+      return value && *value ? std::string(value) : fallback;
+    }
+
+    /**
+     * the cache of the user: TNP_TAPE_CACHE, otherwise tnp-tapes in $XDG_CACHE_HOME or $HOME/.cache,
+     * empty without any of them
+     */
+    std::string userCache() {
+      const std::string configured = environment("TNP_TAPE_CACHE", "");
+      if (!configured.empty())
+	return configured;
+      const std::string xdg = environment("XDG_CACHE_HOME", "");
+      if (!xdg.empty())
+	return xdg + "/tnp-tapes";
+      const std::string home = environment("HOME", "");
+      return home.empty() ? home : home + "/.cache/tnp-tapes";
+    }
+
+    /**
+     * compiles code into base.so, with its checksum in base.sum and the code in base.c.
+     * All files are created under names from mkstemps() and renamed when complete,
+     * the object first, so a matching source always has its object and checksum.
+     */
+    bool build(const std::string& compiler, const std::string& flags, const std::string& code,
+	       const std::string& base, std::string& sum) {
+      std::string source, object, log, sumFile;
+      if (!writeTemporary(base + ".XXXXXX.c", ".c", code, source))
+	return false;
+      if (!writeTemporary(base + ".XXXXXX.so", ".so", "", object) ||
+	  !writeTemporary(base + ".XXXXXX.log", ".log", "", log)) {
+	std::remove(source.c_str());
+	std::remove(object.c_str());
+	return false;
+      }
+
+      const std::string command = compiler + " " + flags + " -o " + quote(object) + " " + quote(source)
+	+ " > " + quote(log) + " 2>&1";
+      std::string content;
+      const bool built = std::system(command.c_str()) == 0 && readFile(object, content) && !content.empty();
+      if (built) {
+	sum = checksum(content);
+	std::remove(log.c_str());
+      }
+      if (!built || !writeTemporary(base + ".XXXXXX.sum", ".sum", sum, sumFile)) {
+	std::remove(source.c_str());
+	std::remove(object.c_str());
+	return false;
+      }
+
+      return std::rename(object.c_str(), (base + ".so").c_str()) == 0 &&
+	std::rename(sumFile.c_str(), (base + ".sum").c_str()) == 0 &&
+	std::rename(source.c_str(), (base + ".c").c_str()) == 0;
+    }
+  }
+
+  CompiledTape::CompiledTape(const Tape& tape, std::shared_ptr<void> library, TapeEntry entry) :
+    tape(tape), width(tape.params() + 1), size(tape.size()),
+    arena(tape.slots() * tape.size(), 0.0),
+    scratch(TapeEvaluator::scratchSize(tape.order(), tape.params() + 1)),
+    library(library), entry(entry) {
+    Multiplication::ensureExistance(tape.order());
+    CompositionCache::staticGetInstance(tape.order());
+  }
+
+  void CompiledTape::kernel(const void* context, unsigned int i, double* arena, double* scratch) {
+    const CompiledTape* self = static_cast<const CompiledTape*>(context);
+    TapeEvaluator::execute(self->tape.instructions()[i], arena, self->tape.order(), self->width, scratch);
+  }
+
+  void CompiledTape::run() {
+    if (entry) {
+      entry(arena.data(), scratch.data(), &CompiledTape::kernel, this);
+      return;
+    }
+    for (const TapeInstruction& i : tape.instructions())
+      TapeEvaluator::execute(i, arena.data(), tape.order(), width, scratch.data());
+  }
+
+  std::vector<NPNumber> CompiledTape::operator()(const std::vector<NPNumber>& inputs) {
+    std::vector<NPNumber> res;
+    if (!tape.accepts(inputs))
+      return res;
+
+    for (unsigned int i = 0; i < inputs.size(); ++i)
+      input(i).assign(inputs[i]);
+
+    run();
+
+    res.reserve(tape.outputs().size());
+    for (unsigned int i = 0; i < tape.outputs().size(); ++i)
+      res.push_back(output(i).toNPNumber());
+    return res;
+  }
+
+  TapeCompiler::TapeCompiler() :
+    _compiler(environment("TNP_TAPE_COMPILER", TNP_TAPE_COMPILER)),
+    _flags("-std=gnu99 -O3 -march=native -fPIC -shared"),
+    _directory(userCache()) {}
+
+  TapeCompiler::TapeCompiler(const std::string& compiler, const std::string& flags, const std::string& directory) :
+    _compiler(compiler), _flags(flags), _directory(directory) {}
+
+  std::string TapeCompiler::source(const Tape& tape) {
+    const unsigned int order = tape.order();
+    const unsigned int width = tape.params() + 1;
+    const unsigned int size = tape.size();
+    Multiplication::ensureExistance(order);
+
+    std::ostringstream out;
+    out << "/* generated by tnp: " << tape.instructions().size() << " instructions on "
+	<< tape.slots() << " slots, params " << tape.params() << ", order " << order << " */\n"
+	<< "#include <string.h>\n\n"
+	<< "typedef void (*tape_kernel)(const void* context, unsigned int i, double* x, double* scratch);\n\n"
+	<< "static inline double tape_bits(unsigned long long bits) {\n"
+	<< "  double d;\n"
+	<< "  memcpy(&d, &bits, sizeof(d));\n"
+	<< "  return d;\n"
+	<< "}\n\n"
+	<< "static inline void tape_constant(double* restrict t, double value) {\n"
+	<< "  unsigned int k;\n"
+	<< "  for (k = 0; k < " << size << "; ++k)\n"
+	<< "    t[k] = 0.0;\n"
+	<< "  t[0] = value;\n"
+	<< "}\n\n"
+	<< "static inline void tape_add(const double* restrict a, const double* restrict b, double* restrict t) {\n"
+	<< "  unsigned int k;\n"
+	<< "  for (k = 0; k < " << size << "; ++k)\n"
+	<< "    t[k] = a[k] + b[k];\n"
+	<< "}\n\n"
+	<< "static inline void tape_sub(const double* restrict a, const double* restrict b, double* restrict t) {\n"
+	<< "  unsigned int k;\n"
+	<< "  for (k = 0; k < " << size << "; ++k)\n"
+	<< "    t[k] = a[k] - b[k];\n"
+	<< "}\n\n"
+	<< "static inline void tape_add_scalar(const double* restrict a, double s, double* restrict t) {\n"
+	<< "  unsigned int k;\n"
+	<< "  for (k = 0; k < " << size << "; ++k)\n"
+	<< "    t[k] = a[k];\n"
+	<< "  t[0] += s;\n"
+	<< "}\n\n"
+	<< "static inline void tape_scale(const double* restrict a, double s, double* restrict t) {\n"
+	<< "  unsigned int k;\n"
+	<< "  for (k = 0; k < " << size << "; ++k)\n"
+	<< "    t[k] = a[k] * s;\n"
+	<< "}\n\n";
+
+    emitProduct(out, order, width);
+
+    out << "void tnp_tape_run(double* x, double* scratch, tape_kernel kernel, const void* context) {\n";
+    const std::vector<TapeInstruction>& all = tape.instructions();
+    for (unsigned int k = 0; k < all.size(); ++k) {
+      const TapeInstruction& i = all[k];
+      const std::string t = slot(i.target, size);
+      switch (i.op) {
+      case TAPE_CONSTANT:
+	out << "  tape_constant(" << t << ", " << literal(i.scalar) << ");\n";
+	break;
+      case TAPE_ADD:
+	out << "  tape_add(" << slot(i.a, size) << ", " << slot(i.b, size) << ", " << t << ");\n";
+	break;
+      case TAPE_SUB:
+	out << "  tape_sub(" << slot(i.a, size) << ", " << slot(i.b, size) << ", " << t << ");\n";
+	break;
+      case TAPE_MUL:
+	out << "  tape_mul(" << slot(i.a, size) << ", " << slot(i.b, size) << ", " << t << ");\n";
+	break;
+      case TAPE_ADD_SCALAR:
+	out << "  tape_add_scalar(" << slot(i.a, size) << ", " << literal(i.scalar) << ", " << t << ");\n";
+	break;
+      case TAPE_SCALE:
+	out << "  tape_scale(" << slot(i.a, size) << ", " << literal(i.scalar) << ", " << t << ");\n";
+	break;
+      default:
+	out << "  kernel(context, " << k << ", x, scratch);\n";
+	break;
+      }
+    }
+    out << "}\n";
+
+    return out.str();
+  }
+
+  std::uint64_t TapeCompiler::hash(const Tape& tape) {
+    std::uint64_t h = FNV_OFFSET;
+    h = fnv(h, tape.params());
+    h = fnv(h, tape.order());
+    h = fnv(h, tape.slots());
+    for (const TapeInstruction& i : tape.instructions()) {
+      h = fnv(h, (int) i.op);
+      h = fnv(h, i.target);
+      h = fnv(h, i.a);
+      h = fnv(h, i.b);
+      h = fnv(h, i.n);
+      h = fnv(h, i.scalar);
+    }
+    for (unsigned int s : tape.inputs())
+      h = fnv(h, s);
+    for (unsigned int s : tape.outputs())
+      h = fnv(h, s);
+    return h;
+  }
+
+  std::shared_ptr<void> TapeCompiler::load(const Tape& tape) const {
+    const std::string code = source(tape);
+
+    std::uint64_t key = hash(tape);
+    key = fnv(key, _compiler.data(), _compiler.size());
+    key = fnv(key, _flags.data(), _flags.size());
+    key = fnv(key, hostProcessor().data(), hostProcessor().size());
+
+    std::lock_guard<std::mutex> l(loadLock());
+
+    Loaded& entry = loaded()[key];
+    if (entry.source == code) {
+      const std::shared_ptr<void> library = entry.library.lock();
+      if (library)
+	return library;
+    }
+
+    if (_directory.empty() || !privateDirectory(_directory))
+      return std::shared_ptr<void>();
+
+    /*
+     * The sources are kept next to the shared objects to tell hash collisions from hits,
+     * the checksums to load only objects that did not change since they were built.
+     */
+    const std::string base = _directory + "/tnp_tape_" + hex(key);
+    const std::string object = base + ".so";
+    std::string cached;
+    std::string sum;
+    int fd = -1;
+    if (readFile(base + ".c", cached) && cached == code && readFile(base + ".sum", sum))
+      fd = openVerified(object, sum);
+    if (fd < 0 && build(_compiler, _flags, code, base, sum))
+      fd = openVerified(object, sum);
+    if (fd < 0)
+      return std::shared_ptr<void>();
+
+    void* handle = openLibrary(fd, object);
+    close(fd);
+    if (!handle)
+      return std::shared_ptr<void>();
+    if (!dlsym(handle, "tnp_tape_run")) {
+      dlclose(handle);
+      return std::shared_ptr<void>();
+    }
+
+    const std::shared_ptr<void> library(handle, dlclose);
+    entry.source = code;
+    entry.library = library;
+    return library;
+  }
+
+  CompiledTape TapeCompiler::compile(const Tape& tape) const {
+    const std::shared_ptr<void> library = load(tape);
+    TapeEntry entry = 0;
+    if (library)
+      entry = reinterpret_cast<TapeEntry>(dlsym(library.get(), "tnp_tape_run"));
+    return CompiledTape(tape, library, entry);
+  }
+}
@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2012 uebb.tu-berlin.de.
+ *
+ * This file is part of tnp
+ *
+ * tnp is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * tnp is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with tnp. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <tnp/tapeoptimizer.hpp>
+
+#include <map>
+#include <tuple>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+namespace tnp {
+
+  namespace {
+    const unsigned int NONE = ~0u;
+
+    TapeInstruction constantInstruction(unsigned int target, double value) {
+      TapeInstruction i;
+      i.op = TAPE_CONSTANT;
+      i.target = target;
+      i.a = 0;
+      i.b = 0;
+      i.n = 0;
+      i.scalar = value;
+      return i;
+    }
+
+    /**
+     * the instruction on constant operands, evaluated on NPNumber constants
+     */
+    std::pair<double, double> foldValues(const TapeInstruction& i, double a, double b) {
+      const NPNumber x(0, 0, a);
+      const NPNumber y(0, 0, b);
+      NPNumber r(0, 0, 0.0);
+      NPNumber second(0, 0, 0.0);
+
+      switch (i.op) {
+      case TAPE_CONSTANT: r = NPNumber(0, 0, i.scalar); break;
+      case TAPE_ADD: r = x + y; break;
+      case TAPE_SUB: r = x - y; break;
+      case TAPE_MUL: r = x * y; break;
+      case TAPE_ADD_SCALAR: r = x + i.scalar; break;
+      case TAPE_SCALE: r = x * i.scalar; break;
+      case TAPE_POW_INT: r = x.pow(i.n); break;
+      case TAPE_POW_REAL: r = x.pow(i.scalar); break;
+      case TAPE_POW: r = x.pow(y); break;
+      case TAPE_ATAN2: r = x.atan2(y); break;
+      case TAPE_HYPOT: r = x.hypot(y); break;
+      case TAPE_SQRT: r = x.sqrt(); break;
+      case TAPE_CBRT: r = x.cbrt(); break;
+      case TAPE_EXP: r = x.exp(); break;
+      case TAPE_LOG: r = x.log(); break;
+      case TAPE_APPLY: r = x.apply((unsigned int)i.n); break;
+      case TAPE_SINCOS: {
+	const std::pair<NPNumber, NPNumber> sc = x.sincos();
+	r = sc.first;
+	second = sc.second;
+	break;
+      }
+      case TAPE_SINHCOSH: {
+	const std::pair<NPNumber, NPNumber> sc = x.sinhcosh();
+	r = sc.first;
+	second = sc.second;
+	break;
+      }
+      }
+      return std::make_pair(r.der(0, 0), second.der(0, 0));
+    }
+
+    /* operation, operands, integer and the bits of the scalar (0.0 and -0.0 differ) */
+    typedef std::tuple<int, unsigned int, unsigned int, int, std::uint64_t> Key;
+
+    Key keyOf(const TapeInstruction& i) {
+      std::uint64_t bits;
+      std::memcpy(&bits, &i.scalar, sizeof(bits));
+      const unsigned int operands = i.operands();
+      unsigned int a = operands > 0 ? i.a : 0;
+      unsigned int b = operands > 1 ? i.b : 0;
+      // the only operation whose kernel is symmetric bit for bit
+      if (i.op == TAPE_ADD && b < a)
+	std::swap(a, b);
+      return Key(i.op, a, b, i.n, bits);
+    }
+  }
+
+  Tape TapeOptimizer::optimize(const Tape& tape, unsigned int passes, Report* report) {
+    Report r;
+    std::memset(&r, 0, sizeof(r));
+    r.instructionsBefore = tape.instructions().size();
+    r.slotsBefore = tape.slots();
+
+    Tape res(tape);
+    if (passes & TAPE_FOLD)
+      res = fold(res, r);
+    if (passes & TAPE_CSE)
+      res = eliminateCommon(res, r);
+    if (passes & TAPE_DCE)
+      res = eliminateDead(res, r);
+    if (passes & TAPE_SLOTS)
+      res = allocateSlots(res);
+
+    r.instructionsAfter = res.instructions().size();
+    r.slotsAfter = res.slots();
+    if (report)
+      *report = r;
+    return res;
+  }
+
+  Tape TapeOptimizer::fold(const Tape& tape, Report& report) {
+    std::vector<bool> known(tape.slots(), false);
+    std::vector<double> value(tape.slots(), 0.0);
+    std::vector<TapeInstruction> instructions;
+    instructions.reserve(tape.instructions().size());
+
+    for (TapeInstruction i : tape.instructions()) {
+      const unsigned int operands = i.operands();
+      const bool knownA = operands > 0 && known[i.a];
+      const bool knownB = operands > 1 && known[i.b];
+
+      if (i.op == TAPE_CONSTANT) {
+	known[i.target] = true;
+	value[i.target] = i.scalar;
+      } else if (knownA && (operands == 1 || knownB)) {
+	const std::pair<double, double> v = foldValues(i, value[i.a], operands > 1 ? value[i.b] : 0.0);
+	known[i.target] = true;
+	value[i.target] = v.first;
+	if (i.twoResults()) {
+	  known[i.b] = true;
+	  value[i.b] = v.second;
+	  instructions.push_back(constantInstruction(i.b, v.second));
+	}
+	i = constantInstruction(i.target, v.first);
+	report.folded++;
+      } else if (knownA || knownB) {
+	/* the scalar forms NPNumber uses for constant operands */
+	const TapeOp op = i.op;
+	if (op == TAPE_ADD || op == TAPE_MUL || (op == TAPE_SUB && knownB) || (op == TAPE_POW && knownB)) {
+	  const double c = knownB ? value[i.b] : value[i.a];
+	  i.a = knownB ? i.a : i.b;
+	  i.b = 0;
+	  i.op = op == TAPE_MUL ? TAPE_SCALE : op == TAPE_POW ? TAPE_POW_REAL : TAPE_ADD_SCALAR;
+	  i.scalar = op == TAPE_SUB ? -c : c;
+	  report.simplified++;
+	}
+      }
+      instructions.push_back(i);
+    }
+
+    return Tape(tape.params(), tape.order(), tape.slots(), instructions, tape.inputs(), tape.outputs());
+  }
+
+  Tape TapeOptimizer::eliminateCommon(const Tape& tape, Report& report) {
+    std::vector<unsigned int> rename(tape.slots());
+    for (unsigned int s = 0; s < rename.size(); ++s)
+      rename[s] = s;
+
+    std::map<Key, TapeInstruction> seen;
+    std::vector<TapeInstruction> instructions;
+    instructions.reserve(tape.instructions().size());
+
+    for (TapeInstruction i : tape.instructions()) {
+      const unsigned int operands = i.operands();
+      if (operands > 0)
+	i.a = rename[i.a];
+      if (operands > 1)
+	i.b = rename[i.b];
+
+      const Key key = keyOf(i);
+      const std::map<Key, TapeInstruction>::const_iterator first = seen.find(key);
+      if (first != seen.end()) {
+	rename[i.target] = first->second.target;
+	if (i.twoResults())
+	  rename[i.b] = first->second.b;
+	report.common++;
+      } else {
+	seen[key] = i;
+	instructions.push_back(i);
+      }
+    }
+
+    std::vector<unsigned int> outputs(tape.outputs());
+    for (unsigned int& o : outputs)
+      o = rename[o];
+
+    return Tape(tape.params(), tape.order(), tape.slots(), instructions, tape.inputs(), outputs);
+  }
+
+  Tape TapeOptimizer::eliminateDead(const Tape& tape, Report& report) {
+    std::vector<bool> live(tape.slots(), false);
+    for (unsigned int o : tape.outputs())
+      live[o] = true;
+
+    const std::vector<TapeInstruction>& all = tape.instructions();
+    std::vector<bool> keep(all.size(), false);
+    for (unsigned int k = all.size(); k-- > 0;) {
+      const TapeInstruction& i = all[k];
+      if (!live[i.target] && !(i.twoResults() && live[i.b])) {
+	report.dead++;
+	continue;
+      }
+      keep[k] = true;
+      const unsigned int operands = i.operands();
+      if (operands > 0)
+	live[i.a] = true;
+      if (operands > 1)
+	live[i.b] = true;
+    }
+
+    std::vector<TapeInstruction> instructions;
+    for (unsigned int k = 0; k < all.size(); ++k)
+      if (keep[k])
+	instructions.push_back(all[k]);
+
+    return Tape(tape.params(), tape.order(), tape.slots(), instructions, tape.inputs(), tape.outputs());
+  }
+
+  Tape TapeOptimizer::allocateSlots(const Tape& tape) {
+    const std::vector<TapeInstruction>& all = tape.instructions();
+
+    /* the last instruction reading each slot, NONE if there is none */
+    std::vector<unsigned int> lastUse(tape.slots(), NONE);
+    for (unsigned int k = 0; k < all.size(); ++k) {
+      const unsigned int operands = all[k].operands();
+      if (operands > 0)
+	lastUse[all[k].a] = k;
+      if (operands > 1)
+	lastUse[all[k].b] = k;
+    }
+
+    std::vector<bool> pinned(tape.slots(), false);
+    for (unsigned int s : tape.inputs())
+      pinned[s] = true;
+    for (unsigned int s : tape.outputs())
+      pinned[s] = true;
+
+    std::vector<unsigned int> assigned(tape.slots(), NONE);
+    std::vector<unsigned int> free;
+    unsigned int slots = 0;
+
+    std::vector<unsigned int> inputs(tape.inputs());
+    for (unsigned int& s : inputs) {
+      if (assigned[s] == NONE)
+	assigned[s] = slots++;
+      s = assigned[s];
+    }
+
+    std::vector<TapeInstruction> instructions(all);
+    for (unsigned int k = 0; k < instructions.size(); ++k) {
+      TapeInstruction& i = instructions[k];
+      const unsigned int operands = i.operands();
+      const unsigned int a = i.a;
+      const unsigned int b = i.b;
+      if (operands > 0)
+	i.a = assigned[a];
+      if (operands > 1)
+	i.b = assigned[b];
+
+      /* the targets are assigned before the operands are released, so they never alias */
+      std::vector<unsigned int> targets(1, i.target);
+      if (i.twoResults())
+	targets.push_back(b);
+      for (unsigned int t : targets) {
+	if (assigned[t] == NONE) {
+	  if (free.empty()) {
+	    assigned[t] = slots++;
+	  } else {
+	    assigned[t] = free.back();
+	    free.pop_back();
+	  }
+	}
+      }
+      i.target = assigned[i.target];
+      if (i.twoResults())
+	i.b = assigned[b];
+
+      if (operands > 0 && lastUse[a] == k && !pinned[a])
+	free.push_back(assigned[a]);
+      if (operands > 1 && b != a && lastUse[b] == k && !pinned[b])
+	free.push_back(assigned[b]);
+      for (unsigned int t : targets)
+	if (lastUse[t] == NONE && !pinned[t])
+	  free.push_back(assigned[t]);
+    }
+
+    std::vector<unsigned int> outputs(tape.outputs());
+    for (unsigned int& s : outputs)
+      s = assigned[s];
+
+    return Tape(tape.params(), tape.order(), slots, instructions, inputs, outputs);
+  }
+
+  std::ostream& operator<<(std::ostream& out, const TapeOptimizer::Report& r) {
+    out << "instructions " << r.instructionsBefore << " -> " << r.instructionsAfter
+	<< ", slots " << r.slotsBefore << " -> " << r.slotsAfter
+	<< " (folded " << r.folded << ", simplified " << r.simplified
+	<< ", common " << r.common << ", dead " << r.dead << ")";
+    return out;
+  }
+}
@@ -19,31 +19,82 @@
 
 #include <prettyprint.hpp>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #include <tnp.hpp>
+#include <tnp/npnumberview.hpp>
+#include <tnp/context.hpp>
 #include <tnp.h>
 
 using namespace tnp;
 
 extern "C" {
 
-  struct tnp_number : public NPNumber {};
+  struct tnp_number : public NPNumber {
+    tnp_number(const NPNumber& n) : NPNumber(n) {}
+    tnp_number(NPNumber&& n) : NPNumber(std::move(n)) {}
+  };
+
+  /**
+   * a new handle, drawn from the allocator of the context
+   */
+  static struct tnp_number* make(struct tnp_context* ctx, NPNumber&& n) {
+    return new (ctx->allocate(sizeof(tnp_number))) tnp_number(std::move(n));
+  }
   
+  /**
+   * the fields of a handle as the target of a *_into function
+   */
+  static NPNumberView fieldsOf(struct tnp_number* nr) {
+    return NPNumberView(&nr->der(0, 0), nr->params(), nr->order());
+  }
+
+  /**
+   * true if the fields of target can hold a result of the shape of a. The *_into functions
+   * assign other targets the result of the allocating operation, like tnp_number_assign().
+   */
+  static bool fits(const struct tnp_number* target, const struct tnp_number* a) {
+    return target->params() == a->params() && target->order() == a->order();
+  }
+
+  static void assign(struct tnp_number* target, NPNumber&& n) {
+    static_cast<NPNumber&>(*target) = std::move(n);
+  }
+
   struct tnp_number* tnp_number_create(int params, int order) {
-    return static_cast<tnp_number*>(new NPNumber(params, order));
+    return tnp_number_create_ctx(tnp_context_default(), params, order);
+  }
+
+  struct tnp_number* tnp_number_create_ctx(struct tnp_context* ctx, int params, int order) {
+    ctx->ensure(order);
+    return make(ctx, NPNumber(params, order));
   }
 
   struct tnp_number* tnp_number_create_variable(double val, int nr, int params, int order) {
-    const int width = (params+1);
-    return static_cast<tnp_number*>(new NPNumber(width, variable(val, nr, width * (order+1))));
+    return tnp_number_create_variable_ctx(tnp_context_default(), val, nr, params, order);
+  }
+
+  struct tnp_number* tnp_number_create_variable_ctx(struct tnp_context* ctx, double val, int nr, int params, int order) {
+    ctx->ensure(order);
+    return make(ctx, NPNumber(params + 1, variable(val, nr, (params + 1) * (order+1))));
   }
 
   struct tnp_number* tnp_number_create_constant(double val, int params, int order) {
-    const int width = (params+1);
-    return static_cast<tnp_number*>(new NPNumber(width, constant(val, width * (order+1))));
+    return tnp_number_create_constant_ctx(tnp_context_default(), val, params, order);
   }
-  
+
+  struct tnp_number* tnp_number_create_constant_ctx(struct tnp_context* ctx, double val, int params, int order) {
+    ctx->ensure(order);
+    return make(ctx, NPNumber(params, order, val));
+  }
+
   void tnp_number_delete(struct tnp_number* nr) {
-    delete nr;
+    tnp_number_delete_ctx(tnp_context_default(), nr);
+  }
+
+  void tnp_number_delete_ctx(struct tnp_context* ctx, struct tnp_number* nr) {
+    nr->~tnp_number();
+    ctx->deallocate(nr, sizeof(tnp_number));
   }
   
   int tnp_number_params(struct tnp_number* nr) {
@@ -71,27 +122,57 @@ extern "C" {
   }
 
   struct tnp_number* tnp_number_add(struct tnp_number* a, struct tnp_number* b) {
-    return static_cast<tnp_number*>(new NPNumber((*a) + (*b)));
+    return tnp_number_add_ctx(tnp_context_default(), a, b);
+  }
+
+  struct tnp_number* tnp_number_add_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number* b) {
+    ctx->ensure(a->order());
+    return make(ctx, (*a) + (*b));
   }
 
   struct tnp_number* tnp_number_dadd(struct tnp_number* a, double b) {
-    return static_cast<tnp_number*>(new NPNumber((*a) + b));
+    return tnp_number_dadd_ctx(tnp_context_default(), a, b);
+  }
+
+  struct tnp_number* tnp_number_dadd_ctx(struct tnp_context* ctx, struct tnp_number* a, double b) {
+    ctx->ensure(a->order());
+    return make(ctx, (*a) + b);
   }
 
   struct tnp_number* tnp_number_mult(struct tnp_number* a, struct tnp_number* b) {
-    return static_cast<tnp_number*>(new NPNumber((*a) * (*b)));
+    return tnp_number_mult_ctx(tnp_context_default(), a, b);
+  }
+
+  struct tnp_number* tnp_number_mult_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number* b) {
+    ctx->ensure(a->order());
+    return make(ctx, (*a) * (*b));
   }
 
   struct tnp_number* tnp_number_dmult(struct tnp_number* a, double b) {
-    return static_cast<tnp_number*>(new NPNumber((*a) * b));
+    return tnp_number_dmult_ctx(tnp_context_default(), a, b);
+  }
+
+  struct tnp_number* tnp_number_dmult_ctx(struct tnp_context* ctx, struct tnp_number* a, double b) {
+    ctx->ensure(a->order());
+    return make(ctx, (*a) * b);
   }
 
   struct tnp_number* tnp_number_sub(struct tnp_number* a, struct tnp_number* b) {
-    return static_cast<tnp_number*>(new NPNumber((*a) - (*b)));
+    return tnp_number_sub_ctx(tnp_context_default(), a, b);
+  }
+
+  struct tnp_number* tnp_number_sub_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number* b) {
+    ctx->ensure(a->order());
+    return make(ctx, (*a) - (*b));
   }
 
   struct tnp_number* tnp_number_dsub(struct tnp_number* a, double b) {
-    return static_cast<tnp_number*>(new NPNumber((*a) - b));
+    return tnp_number_dsub_ctx(tnp_context_default(), a, b);
+  }
+
+  struct tnp_number* tnp_number_dsub_ctx(struct tnp_context* ctx, struct tnp_number* a, double b) {
+    ctx->ensure(a->order());
+    return make(ctx, (*a) - b);
   }
 
 /*
@@ -105,7 +186,368 @@ extern "C" {
 */
 
   struct tnp_number* tnp_number_pow(struct tnp_number* a, int power) {
-    return static_cast<tnp_number*>(new NPNumber(a -> pow(power)));
+    return tnp_number_pow_ctx(tnp_context_default(), a, power);
+  }
+
+  struct tnp_number* tnp_number_pow_ctx(struct tnp_context* ctx, struct tnp_number* a, int power) {
+    ctx->ensure(a->order());
+    return make(ctx, a -> pow(power, ctx->powerMethod()));
+  }
+
+  struct tnp_number* tnp_number_powr(struct tnp_number* a, double power) {
+    return tnp_number_powr_ctx(tnp_context_default(), a, power);
+  }
+
+  struct tnp_number* tnp_number_powr_ctx(struct tnp_context* ctx, struct tnp_number* a, double power) {
+    ctx->ensure(a->order());
+    return make(ctx, a -> pow(power));
+  }
+
+  struct tnp_number* tnp_number_npow(struct tnp_number* a, struct tnp_number* b) {
+    return tnp_number_npow_ctx(tnp_context_default(), a, b);
+  }
+
+  struct tnp_number* tnp_number_npow_ctx(struct tnp_context* ctx, struct tnp_number* a, struct tnp_number* b) {
+    ctx->ensure(a->order());
+    return make(ctx, a -> pow(*b));
+  }
+
+  struct tnp_number* tnp_number_atan2(struct tnp_number* y, struct tnp_number* x) {
+    return tnp_number_atan2_ctx(tnp_context_default(), y, x);
+  }
+
+  struct tnp_number* tnp_number_atan2_ctx(struct tnp_context* ctx, struct tnp_number* y, struct tnp_number* x) {
+    ctx->ensure(y->order());
+    return make(ctx, y -> atan2(*x));
+  }
+
+  struct tnp_number* tnp_number_hypot(struct tnp_number* x, struct tnp_number* y) {
+    return tnp_number_hypot_ctx(tnp_context_default(), x, y);
+  }
+
+  struct tnp_number* tnp_number_hypot_ctx(struct tnp_context* ctx, struct tnp_number* x, struct tnp_number* y) {
+    ctx->ensure(x->order());
+    return make(ctx, x -> hypot(*y));
+  }
+
+  struct tnp_number* tnp_number_sqrt(struct tnp_number* a) {
+    return tnp_number_sqrt_ctx(tnp_context_default(), a);
+  }
+
+  struct tnp_number* tnp_number_sqrt_ctx(struct tnp_context* ctx, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    return make(ctx, a -> sqrt());
+  }
+
+  struct tnp_number* tnp_number_cbrt(struct tnp_number* a) {
+    return tnp_number_cbrt_ctx(tnp_context_default(), a);
+  }
+
+  struct tnp_number* tnp_number_cbrt_ctx(struct tnp_context* ctx, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    return make(ctx, a -> cbrt());
+  }
+
+  struct tnp_number* tnp_number_apply(struct tnp_number* a, int function) {
+    return tnp_number_apply_ctx(tnp_context_default(), a, function);
+  }
+
+  struct tnp_number* tnp_number_apply_ctx(struct tnp_context* ctx, struct tnp_number* a, int function) {
+    if (function < 0 || !FunctionRegistry::valid(function))
+      return NULL;
+    ctx->ensure(a->order());
+    return make(ctx, a -> apply(function));
+  }
+
+  void tnp_number_apply_many(struct tnp_number* a, int* functions, int m, struct tnp_number** results) {
+    tnp_number_apply_many_ctx(tnp_context_default(), a, functions, m, results);
+  }
+
+  void tnp_number_apply_many_ctx(struct tnp_context* ctx, struct tnp_number* a, int* functions, int m,
+				 struct tnp_number** results) {
+    for (int i = 0; i < m; ++i) {
+      if (functions[i] < 0 || !FunctionRegistry::valid(functions[i])) {
+	std::fill(results, results + m, (struct tnp_number*) NULL);
+	return;
+      }
+    }
+    ctx->ensure(a->order());
+    std::vector<NPNumber> res = a -> apply(std::vector<unsigned int>(functions, functions + m));
+    for (int i = 0; i < m; ++i)
+      results[i] = make(ctx, std::move(res[i]));
+  }
+
+  struct tnp_number* tnp_number_exp(struct tnp_number* a) {
+    return tnp_number_exp_ctx(tnp_context_default(), a);
+  }
+
+  struct tnp_number* tnp_number_exp_ctx(struct tnp_context* ctx, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    return make(ctx, a -> exp());
+  }
+
+  struct tnp_number* tnp_number_log(struct tnp_number* a) {
+    return tnp_number_log_ctx(tnp_context_default(), a);
+  }
+
+  struct tnp_number* tnp_number_log_ctx(struct tnp_context* ctx, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    return make(ctx, a -> log());
+  }
+
+  void tnp_number_sincos(struct tnp_number* a, struct tnp_number** sin, struct tnp_number** cos) {
+    tnp_number_sincos_ctx(tnp_context_default(), a, sin, cos);
+  }
+
+  void tnp_number_sincos_ctx(struct tnp_context* ctx, struct tnp_number* a,
+			     struct tnp_number** sin, struct tnp_number** cos) {
+    ctx->ensure(a->order());
+    std::pair<NPNumber, NPNumber> sc = a -> sincos();
+    *sin = make(ctx, std::move(sc.first));
+    *cos = make(ctx, std::move(sc.second));
+  }
+
+  void tnp_number_sinhcosh(struct tnp_number* a, struct tnp_number** sinh, struct tnp_number** cosh) {
+    tnp_number_sinhcosh_ctx(tnp_context_default(), a, sinh, cosh);
+  }
+
+  void tnp_number_sinhcosh_ctx(struct tnp_context* ctx, struct tnp_number* a,
+			       struct tnp_number** sinh, struct tnp_number** cosh) {
+    ctx->ensure(a->order());
+    std::pair<NPNumber, NPNumber> sc = a -> sinhcosh();
+    *sinh = make(ctx, std::move(sc.first));
+    *cosh = make(ctx, std::move(sc.second));
+  }
+
+  void tnp_number_assign(struct tnp_number* target, struct tnp_number* a) {
+    static_cast<NPNumber&>(*target) = *a;
+  }
+
+  void tnp_number_add_into(struct tnp_number* target, struct tnp_number* a, struct tnp_number* b) {
+    tnp_number_add_into_ctx(tnp_context_default(), target, a, b);
+  }
+
+  void tnp_number_add_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, struct tnp_number* b) {
+    ctx->ensure(a->order());
+    if (fits(target, a) && fits(target, b))
+      fieldsOf(target).sum(*a, *b);
+    else
+      assign(target, (*a) + (*b));
+  }
+
+  void tnp_number_dadd_into(struct tnp_number* target, struct tnp_number* a, double b) {
+    tnp_number_dadd_into_ctx(tnp_context_default(), target, a, b);
+  }
+
+  void tnp_number_dadd_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, double b) {
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).sum(*a, b);
+    else
+      assign(target, (*a) + b);
+  }
+
+  void tnp_number_mult_into(struct tnp_number* target, struct tnp_number* a, struct tnp_number* b) {
+    tnp_number_mult_into_ctx(tnp_context_default(), target, a, b);
+  }
+
+  void tnp_number_mult_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, struct tnp_number* b) {
+    ctx->ensure(a->order());
+    if (fits(target, a) && fits(target, b))
+      fieldsOf(target).product(*a, *b);
+    else
+      assign(target, (*a) * (*b));
+  }
+
+  void tnp_number_dmult_into(struct tnp_number* target, struct tnp_number* a, double b) {
+    tnp_number_dmult_into_ctx(tnp_context_default(), target, a, b);
+  }
+
+  void tnp_number_dmult_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, double b) {
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).scaled(*a, b);
+    else
+      assign(target, (*a) * b);
+  }
+
+  void tnp_number_sub_into(struct tnp_number* target, struct tnp_number* a, struct tnp_number* b) {
+    tnp_number_sub_into_ctx(tnp_context_default(), target, a, b);
+  }
+
+  void tnp_number_sub_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, struct tnp_number* b) {
+    ctx->ensure(a->order());
+    if (fits(target, a) && fits(target, b))
+      fieldsOf(target).difference(*a, *b);
+    else
+      assign(target, (*a) - (*b));
+  }
+
+  void tnp_number_dsub_into(struct tnp_number* target, struct tnp_number* a, double b) {
+    tnp_number_dsub_into_ctx(tnp_context_default(), target, a, b);
+  }
+
+  void tnp_number_dsub_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, double b) {
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).sum(*a, -b);
+    else
+      assign(target, (*a) - b);
+  }
+
+  void tnp_number_pow_into(struct tnp_number* target, struct tnp_number* a, int power) {
+    tnp_number_pow_into_ctx(tnp_context_default(), target, a, power);
+  }
+
+  void tnp_number_pow_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, int power) {
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).pow(*a, power, ctx->powerMethod());
+    else
+      assign(target, a -> pow(power, ctx->powerMethod()));
+  }
+
+  void tnp_number_powr_into(struct tnp_number* target, struct tnp_number* a, double power) {
+    tnp_number_powr_into_ctx(tnp_context_default(), target, a, power);
+  }
+
+  void tnp_number_powr_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, double power) {
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).pow(*a, power);
+    else
+      assign(target, a -> pow(power));
+  }
+
+  void tnp_number_npow_into(struct tnp_number* target, struct tnp_number* a, struct tnp_number* b) {
+    tnp_number_npow_into_ctx(tnp_context_default(), target, a, b);
+  }
+
+  void tnp_number_npow_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, struct tnp_number* b) {
+    ctx->ensure(a->order());
+    if (fits(target, a) && fits(target, b))
+      fieldsOf(target).pow(*a, ConstNPNumberView(*b));
+    else
+      assign(target, a -> pow(*b));
+  }
+
+  void tnp_number_atan2_into(struct tnp_number* target, struct tnp_number* y, struct tnp_number* x) {
+    tnp_number_atan2_into_ctx(tnp_context_default(), target, y, x);
+  }
+
+  void tnp_number_atan2_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* y, struct tnp_number* x) {
+    ctx->ensure(y->order());
+    if (fits(target, y) && fits(target, x))
+      fieldsOf(target).atan2(*y, *x);
+    else
+      assign(target, y -> atan2(*x));
+  }
+
+  void tnp_number_hypot_into(struct tnp_number* target, struct tnp_number* x, struct tnp_number* y) {
+    tnp_number_hypot_into_ctx(tnp_context_default(), target, x, y);
+  }
+
+  void tnp_number_hypot_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* x, struct tnp_number* y) {
+    ctx->ensure(x->order());
+    if (fits(target, x) && fits(target, y))
+      fieldsOf(target).hypot(*x, *y);
+    else
+      assign(target, x -> hypot(*y));
+  }
+
+  void tnp_number_sqrt_into(struct tnp_number* target, struct tnp_number* a) {
+    tnp_number_sqrt_into_ctx(tnp_context_default(), target, a);
+  }
+
+  void tnp_number_sqrt_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).sqrt(*a);
+    else
+      assign(target, a -> sqrt());
+  }
+
+  void tnp_number_cbrt_into(struct tnp_number* target, struct tnp_number* a) {
+    tnp_number_cbrt_into_ctx(tnp_context_default(), target, a);
+  }
+
+  void tnp_number_cbrt_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).cbrt(*a);
+    else
+      assign(target, a -> cbrt());
+  }
+
+  void tnp_number_apply_into(struct tnp_number* target, struct tnp_number* a, int function) {
+    tnp_number_apply_into_ctx(tnp_context_default(), target, a, function);
+  }
+
+  void tnp_number_apply_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a, int function) {
+    if (function < 0 || !FunctionRegistry::valid(function)) {
+      double* fields = &target->der(0, 0);
+      std::fill(fields, fields + (target->params() + 1) * (target->order() + 1), NAN);
+      return;
+    }
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).apply(FunctionRegistry::get(function), *a);
+    else
+      assign(target, a -> apply(function));
+  }
+
+  void tnp_number_exp_into(struct tnp_number* target, struct tnp_number* a) {
+    tnp_number_exp_into_ctx(tnp_context_default(), target, a);
+  }
+
+  void tnp_number_exp_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).exp(*a);
+    else
+      assign(target, a -> exp());
+  }
+
+  void tnp_number_log_into(struct tnp_number* target, struct tnp_number* a) {
+    tnp_number_log_into_ctx(tnp_context_default(), target, a);
+  }
+
+  void tnp_number_log_into_ctx(struct tnp_context* ctx, struct tnp_number* target, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    if (fits(target, a))
+      fieldsOf(target).log(*a);
+    else
+      assign(target, a -> log());
+  }
+
+  void tnp_number_sincos_into(struct tnp_number* sin, struct tnp_number* cos, struct tnp_number* a) {
+    tnp_number_sincos_into_ctx(tnp_context_default(), sin, cos, a);
+  }
+
+  void tnp_number_sincos_into_ctx(struct tnp_context* ctx, struct tnp_number* sin, struct tnp_number* cos, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    if (fits(sin, a) && fits(cos, a)) {
+      fieldsOf(sin).sincos(*a, fieldsOf(cos));
+    } else {
+      std::pair<NPNumber, NPNumber> r = a -> sincos();
+      assign(sin, std::move(r.first));
+      assign(cos, std::move(r.second));
+    }
+  }
+
+  void tnp_number_sinhcosh_into(struct tnp_number* sinh, struct tnp_number* cosh, struct tnp_number* a) {
+    tnp_number_sinhcosh_into_ctx(tnp_context_default(), sinh, cosh, a);
+  }
+
+  void tnp_number_sinhcosh_into_ctx(struct tnp_context* ctx, struct tnp_number* sinh, struct tnp_number* cosh, struct tnp_number* a) {
+    ctx->ensure(a->order());
+    if (fits(sinh, a) && fits(cosh, a)) {
+      fieldsOf(sinh).sinhcosh(*a, fieldsOf(cosh));
+    } else {
+      std::pair<NPNumber, NPNumber> r = a -> sinhcosh();
+      assign(sinh, std::move(r.first));
+      assign(cosh, std::move(r.second));
+    }
   }
 
 }
@@ -202,7 +202,7 @@ namespace tnp {
       for (int o = 0; o <= test.order; o++) {
 	const double res = f->eval(test.arg);
 	BOOST_CHECK_MESSAGE(boost::test_tools::check_is_close(res, npRes.der(0, o), 
-								boost::test_tools::percent_tolerance(1e-10)), 
+								boost::math::fpc::percent_tolerance(1e-10)), 
 			    "Testing function: " << (*test.fun) << "\n" <<
 			    "Derivation: " << o << " = ideal function: " << (*f) << "\n" <<
 			    "argument: " << test.arg << " expected: " << res << "\n" <<
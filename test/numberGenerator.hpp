@@ -43,6 +43,40 @@ namespace tnp {
 
     const std::vector<std::pair<unsigned int, unsigned int>> testDimensions(makeSizes());
 
+    std::vector<std::pair<unsigned int, unsigned int>> makeBenchmarkSizes() {
+      std::vector<std::pair<unsigned int, unsigned int>> sizes;
+      for (unsigned int o = 2; o <= 20; o += 2)
+	sizes.push_back(std::make_pair(2, o));
+      return sizes;
+    }
+
+    const std::vector<std::pair<unsigned int, unsigned int>> benchmarkDimensions(makeBenchmarkSizes());
+
+    std::vector<std::pair<unsigned int, unsigned int>> makePowerBenchmarkSizes() {
+      std::vector<std::pair<unsigned int, unsigned int>> sizes({
+	  std::make_pair(0,2),
+	    std::make_pair(2,4),
+	    std::make_pair(2,10),
+	    std::make_pair(10,2),
+	    std::make_pair(10,5),
+	    std::make_pair(30,3)});
+      return sizes;
+    }
+
+    const std::vector<std::pair<unsigned int, unsigned int>> powerBenchmarkDimensions(makePowerBenchmarkSizes());
+
+    std::vector<std::pair<unsigned int, unsigned int>> makeDispatchBenchmarkSizes() {
+      std::vector<std::pair<unsigned int, unsigned int>> sizes({
+	  std::make_pair(0,2),
+	    std::make_pair(2,2),
+	    std::make_pair(3,3),
+	    std::make_pair(8,4),
+	    std::make_pair(16,6)});
+      return sizes;
+    }
+
+    const std::vector<std::pair<unsigned int, unsigned int>> dispatchBenchmarkDimensions(makeDispatchBenchmarkSizes());
+
     std::vector<NPNumber> makeNumbers() {
       std::vector<NPNumber> v;
       
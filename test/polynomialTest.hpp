@@ -214,7 +214,7 @@ namespace tnp {
 
 	const double res = test.evalValue();
 	BOOST_CHECK_MESSAGE(boost::test_tools::check_is_close(res, npRes.der(0, test.order), 
-							      boost::test_tools::percent_tolerance(1e-10)), 
+							      boost::math::fpc::percent_tolerance(1e-10)), 
 			    "Testing value of: " << (test.orig) << " (" << test.order << " times derived)" << "\n" <<
 			    "Derivation: " << test.der << "\n" <<		    
 			    "argument: " << test.dArgs << "\n" << 
@@ -224,7 +224,7 @@ namespace tnp {
 	for (int v = 0; v < test.dArgs.size() / (test.order+1); v++) {
 	  const double res = test.evalPartialDerivative(v);
 	  BOOST_CHECK_MESSAGE(boost::test_tools::check_is_close(res, npRes.der(v+1, test.order), 
-								boost::test_tools::percent_tolerance(1e-10)), 
+								boost::math::fpc::percent_tolerance(1e-10)), 
 			      "Testing partial derivative (variable " << v << "): " << (test.orig) << " (" << test.order << " times derived)" << "\n" <<
 			      "Derivation: " << test.der << "\n" <<
 			      "argument: " << test.dArgs << "\n" << 
@@ -50,6 +50,78 @@ init_unit_test_suite( int argc, char* argv[] ) {
   framework::master_test_suite().
     add( BOOST_PARAM_TEST_CASE( &testCube, testNumbers().begin(), testNumbers().end() ) );
   
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testExp, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testLog, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testRealPow, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testBinaryPow, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testAtan2Hypot, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testRegisteredFunction, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testFixedNumbers, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testScalarTypes, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testNumberViews, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testAlignedNumbers, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testTransposedNumbers, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testTapes, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testTapeOptimizer, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testParallelTapes, testDimensions.begin(), testDimensions.end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testCompiledTapes, testDimensions.begin(), testDimensions.end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testHandlesInto, testDimensions.begin(), testDimensions.end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testContexts, testDimensions.begin(), testDimensions.end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testExpressionTemplates, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testInPlaceArithmetic, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testConstantShortcuts, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testAffineComposition, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testComposeMany, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testSinCos, testNumbers().begin(), testNumbers().end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testSinhCosh, testNumbers().begin(), testNumbers().end() ) );
+
   framework::master_test_suite().
     add( BOOST_PARAM_TEST_CASE( &testManyMultiplicationsWithOne, testDimensions.begin(), testDimensions.end() ) );
   
@@ -61,6 +133,18 @@ init_unit_test_suite( int argc, char* argv[] ) {
   
   framework::master_test_suite().
     add( BOOST_PARAM_TEST_CASE( &testManyAssignments, testDimensions.begin(), testDimensions.end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testManyPowersByMethod, powerBenchmarkDimensions.begin(), powerBenchmarkDimensions.end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testManyKernelsByShape, dispatchBenchmarkDimensions.begin(), dispatchBenchmarkDimensions.end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testManyPooledHandles, dispatchBenchmarkDimensions.begin(), dispatchBenchmarkDimensions.end() ) );
+
+  framework::master_test_suite().
+    add( BOOST_PARAM_TEST_CASE( &testManyExpsAgainstComposition, benchmarkDimensions.begin(), benchmarkDimensions.end() ) );
   
   const std::vector<UnaryAnalyticFunctionTest>& analyticTestCases = UnaryAnalyticFunctionTest::testCases();
 
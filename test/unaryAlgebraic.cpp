@@ -18,10 +18,18 @@
  */
 
 #include <tnp/npnumber.hpp>
+#include <tnp.h>
 #include <boost/timer/timer.hpp>
 
 #include <tnp/polynomial.hpp>
 
+#include <cmath>
+#include <cstdlib>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 namespace tnp {
   namespace test {
 
@@ -61,6 +69,146 @@ namespace tnp {
       return result;
     }
 
+    std::vector<double> expDerivatives(double x, unsigned int order) {
+      return std::vector<double>(order + 2, std::exp(x));
+    }
+
+    std::vector<double> logDerivatives(double x, unsigned int order) {
+      // [log(x), 1/x, -1/x^2, 2/x^3, ...]
+      std::vector<double> f(order + 2);
+      f[0] = std::log(x);
+      double d = 1.0 / x;
+      for (unsigned int k = 1; k <= order + 1; ++k) {
+	f[k] = d;
+	d *= - (double)k / x;
+      }
+      return f;
+    }
+
+    std::vector<double> powDerivatives(double x, double alpha, unsigned int order) {
+      // [x^a, a*x^(a-1), a*(a-1)*x^(a-2), ...]
+      std::vector<double> f(order + 2);
+      double coefficient = 1.0;
+      for (unsigned int k = 0; k <= order + 1; ++k) {
+	f[k] = coefficient * std::pow(x, alpha - k);
+	coefficient *= alpha - k;
+      }
+      return f;
+    }
+
+    std::vector<double> cyclicDerivatives(double f, double df, double sign, unsigned int order) {
+      std::vector<double> d(order + 2);
+      for (unsigned int k = 0; k <= order + 1; ++k)
+	d[k] = (k % 2 == 0 ? f : df) * ((k / 2) % 2 == 0 ? 1.0 : sign);
+      return d;
+    }
+
+    NPNumber compose(const NPNumber& arg, const std::vector<double>& f) {
+      std::vector<double> target(arg.data().size());
+      arg.comp()->apply(f.data(), arg.data().data(), target.data(), arg.params() + 1);
+      return NPNumber(arg.params() + 1, target);
+    }
+
+    NPNumber productLoop(const NPNumber& a, const NPNumber& b, unsigned int n) {
+      boost::timer::auto_cpu_timer t;
+      NPNumber result(a);
+      for (unsigned int i = 0; i < n; ++i)
+	result = a * b;
+      return result;
+    }
+
+    NPNumber compositionLoop(const NPNumber& arg, const std::vector<double>& f, unsigned int n) {
+      boost::timer::auto_cpu_timer t;
+      std::vector<double> target(arg.data().size());
+      for (unsigned int i = 0; i < n; ++i)
+	arg.comp()->apply(f.data(), arg.data().data(), target.data(), arg.params() + 1);
+      return NPNumber(arg.params() + 1, target);
+    }
+
+    std::string privateDirectory() {
+      const char* tmp = std::getenv("TMPDIR");
+      std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/tnp-test-XXXXXX";
+      std::vector<char> name(pattern.begin(), pattern.end());
+      name.push_back('\0');
+      return mkdtemp(name.data()) ? std::string(name.data()) : std::string();
+    }
+
+    std::vector<std::string> filesIn(const std::string& directory, const std::string& suffix) {
+      std::vector<std::string> files;
+      DIR* dir = opendir(directory.c_str());
+      if (!dir)
+	return files;
+      while (const struct dirent* entry = readdir(dir)) {
+	const std::string name = entry->d_name;
+	if (name == "." || name == ".." || name.size() < suffix.size() ||
+	    name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+	  continue;
+	files.push_back(directory + "/" + name);
+      }
+      closedir(dir);
+      return files;
+    }
+
+    void removeDirectory(const std::string& directory) {
+      for (const std::string& file : filesIn(directory, ""))
+	unlink(file.c_str());
+      rmdir(directory.c_str());
+    }
+
+    NPNumber fromHandle(tnp_number* h) {
+      const unsigned int params = tnp_number_params(h);
+      const unsigned int order = tnp_number_order(h);
+      NPNumber n(params, order);
+      for (unsigned int o = 0; o <= order; ++o)
+	for (unsigned int j = 0; j <= params; ++j)
+	  n.der(j, o) = tnp_number_mixed_derivative(h, o, j);
+      return n;
+    }
+
+    NPNumber handleLoop(unsigned int params, unsigned int order, unsigned int n) {
+      boost::timer::auto_cpu_timer t;
+      tnp_number* a = tnp_number_create_variable(0.5, 1, params, order);
+      tnp_number* b = tnp_number_sqrt(a);
+      tnp_number* result = tnp_number_mult(a, b);
+      for (unsigned int i = 1; i < n; ++i) {
+	tnp_number_delete(result);
+	result = tnp_number_mult(a, b);
+      }
+      const NPNumber last = fromHandle(result);
+      tnp_number_delete(result);
+      tnp_number_delete(b);
+      tnp_number_delete(a);
+      return last;
+    }
+
+    NPNumber expLoop(NPNumber arg, unsigned int n) {
+      cout << "Recurrence: ";
+      boost::timer::auto_cpu_timer t;
+      NPNumber result(arg);
+      for (unsigned int i = 0; i < n; ++i)
+	result = arg.exp();
+      return result;
+    }
+
+    NPNumber powLoop(NPNumber arg, int power, PowerMethod method, unsigned int n) {
+      const char* names[] = {"Automatic: ", "Squaring: ", "Recurrence: ", "Composition: "};
+      cout << names[method];
+      boost::timer::auto_cpu_timer t;
+      NPNumber result(arg);
+      for (unsigned int i = 0; i < n; ++i)
+	result = arg.pow(power, method);
+      return result;
+    }
+
+    NPNumber expCompositionLoop(NPNumber arg, unsigned int n) {
+      cout << "Composition: ";
+      boost::timer::auto_cpu_timer t;
+      NPNumber result(arg);
+      for (unsigned int i = 0; i < n; ++i)
+	result = compose(arg, expDerivatives(arg.der(0, 0), arg.order()));
+      return result;
+    }
+
     NPNumber squareLoop(NPNumber result, unsigned int n) {
       cout << "Running pow() performance evaluation, order=" << result.order() << ", params=" << result.params() << endl;
       cout << "Composition order: " << result.comp()->order << endl;
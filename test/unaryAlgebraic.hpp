@@ -20,8 +20,27 @@
 #define TNP_TEST_UNARY_ALGEBRAIC_ID_HPP 1
 
 #include <tnp/npnumber.hpp>
+#include <tnp/expression.hpp>
+#include <tnp/fixednpnumber.hpp>
+#include <tnp/genericnpnumber.hpp>
+#include <tnp/npnumberview.hpp>
+#include <tnp/alignednpnumber.hpp>
+#include <tnp/transposednpnumber.hpp>
+#include <tnp/tape.hpp>
+#include <tnp/tapeoptimizer.hpp>
+#include <tnp/paralleltape.hpp>
+#include <tnp/tapecompiler.hpp>
+#include <tnp.h>
+#include <tnp/ops.h>
+#include <tnp/context.hpp>
 
 #include <utility>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <boost/test/floating_point_comparison.hpp>
 
@@ -35,6 +54,10 @@ namespace tnp {
 
     const unsigned int MANY_ITERATIONS = 2000000;
 
+    const unsigned int BENCHMARK_ITERATIONS = 10000;
+
+    const unsigned int DISPATCH_ITERATIONS = 100000;
+
     NPNumber multiplyLoop(NPNumber result, unsigned int n);
 
     NPNumber bellLoop(NPNumber result, unsigned int n);
@@ -43,6 +66,57 @@ namespace tnp {
 
     NPNumber squareLoop(NPNumber result, unsigned int n);
 
+    NPNumber expLoop(NPNumber arg, unsigned int n);
+
+    NPNumber powLoop(NPNumber arg, int power, PowerMethod method, unsigned int n);
+
+    NPNumber expCompositionLoop(NPNumber arg, unsigned int n);
+
+    NPNumber productLoop(const NPNumber& a, const NPNumber& b, unsigned int n);
+
+    NPNumber compositionLoop(const NPNumber& arg, const std::vector<double>& f, unsigned int n);
+
+    /**
+     * copies the fields of a C handle
+     */
+    NPNumber fromHandle(tnp_number* h);
+
+    /**
+     * creates and deletes n products through the C API, returns the last one
+     */
+    NPNumber handleLoop(unsigned int params, unsigned int order, unsigned int n);
+
+    /**
+     * a new directory only the user can access, for caches of a test
+     */
+    std::string privateDirectory();
+
+    /**
+     * the paths of the files in a directory ending in suffix
+     */
+    std::vector<std::string> filesIn(const std::string& directory, const std::string& suffix);
+
+    /**
+     * removes a directory and the files in it
+     */
+    void removeDirectory(const std::string& directory);
+
+    /**
+     * reference implementation: apply the derivatives f of a unary function via Composition
+     */
+    NPNumber compose(const NPNumber& arg, const std::vector<double>& f);
+
+    std::vector<double> expDerivatives(double x, unsigned int order);
+
+    std::vector<double> logDerivatives(double x, unsigned int order);
+
+    std::vector<double> powDerivatives(double x, double alpha, unsigned int order);
+
+    /**
+     * derivatives of a function whose derivatives cycle through [f, f', sign*f, sign*f']
+     */
+    std::vector<double> cyclicDerivatives(double f, double df, double sign, unsigned int order);
+
     void checkClose(const NPNumber& expected, const NPNumber& actual) {
       BOOST_CHECK_EQUAL(expected.params(), actual.params());
       BOOST_CHECK_EQUAL(expected.order(), actual.order());
@@ -70,15 +144,22 @@ namespace tnp {
       BOOST_CHECK_EQUAL(in * one, in);
     }
 
+    /**
+     * a constant with its fields stored, i.e. without the constant shortcuts
+     */
+    NPNumber stored(unsigned int params, unsigned int order, double value) {
+      return NPNumber(params + 1, constant(value, (params + 1) * (order + 1)));
+    }
+
     void testManyMultiplicationsWithOne(const std::pair<unsigned int, unsigned int> sizes) {
-      const NPNumber one(sizes.first, sizes.second, 1.0);
+      const NPNumber one = stored(sizes.first, sizes.second, 1.0);
       NPNumber result = multiplyLoop(one, MANY_ITERATIONS);
 
       BOOST_CHECK_EQUAL(result, one);
     }
 
     void testManyAssignments(const std::pair<unsigned int, unsigned int> sizes) {
-      const NPNumber zero(sizes.first, sizes.second, 0.0);
+      const NPNumber zero = stored(sizes.first, sizes.second, 0.0);
       cout << "Testing assignments for " << sizes << endl;
       NPNumber result = assignLoop(zero, MANY_ITERATIONS);
 
@@ -93,7 +174,7 @@ namespace tnp {
     }
 
     void testManySquaresOfOne(const std::pair<unsigned int, unsigned int> sizes) {
-      const NPNumber one(sizes.first, sizes.second, 1.0);
+      const NPNumber one = stored(sizes.first, sizes.second, 1.0);
       NPNumber result = squareLoop(one, MANY_ITERATIONS);
 
       BOOST_CHECK_EQUAL(result, one);
@@ -142,6 +223,897 @@ namespace tnp {
     void testCube(const NPNumber& in) {
       BOOST_CHECK_EQUAL(in.pow(3), in*in*in);
     }
+
+    void testExp(const NPNumber& in) {
+      checkClose(compose(in, expDerivatives(in.der(0, 0), in.order())), in.exp());
+    }
+
+    void testLog(const NPNumber& in) {
+      const NPNumber positive = in.exp();
+      checkClose(compose(positive, logDerivatives(positive.der(0, 0), in.order())), positive.log());
+    }
+
+    void testSinCos(const NPNumber& in) {
+      const std::pair<NPNumber, NPNumber> sc = in.sincos();
+      const double x = in.der(0, 0);
+      checkClose(compose(in, cyclicDerivatives(std::sin(x), std::cos(x), -1.0, in.order())), sc.first);
+      checkClose(compose(in, cyclicDerivatives(std::cos(x), -std::sin(x), -1.0, in.order())), sc.second);
+    }
+
+    void testSinhCosh(const NPNumber& in) {
+      const std::pair<NPNumber, NPNumber> sc = in.sinhcosh();
+      const double x = in.der(0, 0);
+      checkClose(compose(in, cyclicDerivatives(std::sinh(x), std::cosh(x), 1.0, in.order())), sc.first);
+      checkClose(compose(in, cyclicDerivatives(std::cosh(x), std::sinh(x), 1.0, in.order())), sc.second);
+    }
+
+    void testRealPow(const NPNumber& in) {
+      const NPNumber positive = in.exp();
+      const double x = positive.der(0, 0);
+      checkClose(compose(positive, powDerivatives(x, 1.7, in.order())), positive.pow(1.7));
+      checkClose(compose(positive, powDerivatives(x, 0.5, in.order())), positive.sqrt());
+      checkClose(compose(positive, powDerivatives(x, 1.0/3.0, in.order())), positive.cbrt());
+      checkClose(compose(positive, powDerivatives(x, -3, in.order())), positive.pow(-3));
+    }
+
+    void testBinaryPow(const NPNumber& in) {
+      const NPNumber x = in.exp();
+      const NPNumber y = in.sincos().first;
+      checkClose((y * x.log()).exp(), x.pow(y));
+    }
+
+    void testAtan2Hypot(const NPNumber& in) {
+      const NPNumber x = in.exp();
+      const NPNumber y = in.sincos().first;
+      const NPNumber h = x.hypot(y);
+      const std::pair<NPNumber, NPNumber> sc = y.atan2(x).sincos();
+
+      checkClose(x * x + y * y, h * h);
+      checkClose(y, sc.first * h);
+      checkClose(x, sc.second * h);
+    }
+
+    void testRegisteredFunction(const NPNumber& in) {
+      static const unsigned int exp =
+	FunctionRegistry::add([](double x, unsigned int) { return std::exp(x); });
+      static const unsigned int sin =
+	FunctionRegistry::add(nullptr, [](double x, unsigned int n, double* f) {
+	    const std::vector<double> d = cyclicDerivatives(std::sin(x), std::cos(x), -1.0, n - 1);
+	    std::copy(d.begin(), d.end(), f);
+	  });
+
+      checkClose(in.exp(), in.apply(exp));
+      checkClose(in.sincos().first, in.apply(FunctionRegistry::get(sin)));
+
+      /* a tagged constant only asks for the value */
+      const NPNumber c(in.params(), in.order(), 0.25);
+      BOOST_CHECK_EQUAL(c.apply(exp).der(0, 0), std::exp(0.25));
+      BOOST_CHECK_EQUAL(c.apply(sin).der(0, 0), std::sin(0.25));
+
+      /* functions without generators and unknown ids are rejected */
+      BOOST_CHECK_EQUAL(FunctionRegistry::add(nullptr, nullptr), FunctionRegistry::INVALID);
+      BOOST_CHECK_EQUAL(tnp_function_register(NULL, NULL, NULL), -1);
+      BOOST_CHECK(FunctionRegistry::valid(sin));
+      BOOST_CHECK(!FunctionRegistry::valid(FunctionRegistry::size()));
+
+      std::vector<double> a(in.data().begin(), in.data().end());
+      std::vector<double> t(a.size(), 0.0);
+      op_tnp_number_apply(in.params(), in.order(), t.data(), a.data(), -1);
+      BOOST_CHECK(std::isnan(t[0]));
+    }
+
+    template<unsigned int P, unsigned int O> void checkFixed(const NPNumber& in) {
+      typedef FixedNPNumber<P, O> Fixed;
+      const Fixed a(in);
+      const Fixed b = a.sincos().first + 2.0;
+
+      BOOST_CHECK_EQUAL(in, a.toNPNumber());
+      /* same terms in the same order as the dynamic kernel */
+      BOOST_CHECK_EQUAL(in * b.toNPNumber(), (a * b).toNPNumber());
+      BOOST_CHECK_EQUAL(in * 2.0 - b.toNPNumber(), (a * 2.0 - b).toNPNumber());
+      checkClose(in.exp(), a.exp().toNPNumber());
+      checkClose(in.pow(3), a.pow(3).toNPNumber());
+
+      std::vector<double> buffer(Fixed::size);
+      (a * b).copyTo(buffer.data());
+      BOOST_CHECK(Fixed(buffer.data()) == a * b);
+
+      /* of other shapes only the common parameters and orders are copied */
+      BOOST_CHECK(Fixed(NPNumber(P, O, 3.0)) == Fixed(3.0));
+      NPNumber wide(P + 1, O + 1);
+      for (unsigned int i = 0; i < wide.data().size(); ++i)
+	wide.der(i % (P + 2), i / (P + 2)) = i + 1.0;
+      const NPNumber narrow = NPNumber::freeVar(1, O + 3, 0.5);
+      const Fixed w(wide);
+      const Fixed n(narrow);
+      for (unsigned int o = 0; o <= O; ++o)
+	for (unsigned int p = 0; p <= P; ++p) {
+	  BOOST_CHECK_EQUAL(wide.der(p, o), w.der(p, o));
+	  BOOST_CHECK_EQUAL(p <= 1 ? narrow.der(p, o) : 0.0, n.der(p, o));
+	}
+    }
+
+    void testFixedNumbers(const NPNumber& in) {
+      if (in.params() == 1 && in.order() == 1)
+	checkFixed<1, 1>(in);
+      else if (in.params() == 2 && in.order() == 3)
+	checkFixed<2, 3>(in);
+      else if (in.params() == 3 && in.order() == 2)
+	checkFixed<3, 2>(in);
+      else if (in.params() == 10 && in.order() == 5)
+	checkFixed<10, 5>(in);
+    }
+
+    /**
+     * compares a lower or higher precision result, relative to the largest field
+     */
+    template<class T, class Acc>
+    void checkPrecision(const NPNumber& expected, const GenericNPNumber<T, Acc>& actual, double tolerance) {
+      const NPNumber a = actual.toNPNumber();
+      BOOST_CHECK_EQUAL(expected.data().size(), a.data().size());
+
+      double scale = 1.0;
+      for (double d : expected.data())
+	scale = std::max(scale, std::fabs(d));
+
+      for (std::size_t i = 0; i < expected.data().size(); ++i)
+	BOOST_CHECK_SMALL((expected.data()[i] - a.data()[i]) / scale, tolerance);
+    }
+
+    template<class T, class Acc> void checkScalarType(const NPNumber& in, double tolerance) {
+      typedef GenericNPNumber<T, Acc> Number;
+      const NPNumber two = in * 0.5 + 2.0;
+      const Number a(in);
+      const Number b(two);
+
+      checkPrecision(in * two, a * b, tolerance);
+      checkPrecision(in * 2.0 - two, a * T(2) - b, tolerance);
+      checkPrecision(in.exp(), a.exp(), tolerance);
+      checkPrecision(two.log(), b.log(), tolerance);
+    }
+
+    void testScalarTypes(const NPNumber& in) {
+      typedef GenericNPNumber<double> Double;
+      const NPNumber two = in * 0.5 + 2.0;
+
+      /* the double instantiation sums the same terms as NPNumber */
+      BOOST_CHECK_EQUAL(in * two, (Double(in) * Double(two)).toNPNumber());
+      checkClose(in.exp(), Double(in).exp().toNPNumber());
+      checkClose(two.log(), Double(two).log().toNPNumber());
+
+      checkScalarType<float, float>(in, 1e-3);
+      checkScalarType<float, double>(in, 1e-3);
+      checkScalarType<long double, long double>(in, 1e-12);
+    }
+
+    void testNumberViews(const NPNumber& in) {
+      const NPNumber two = in * 0.5 + 2.0;
+      const unsigned int params = in.params();
+      const unsigned int order = in.order();
+      const unsigned int size = (params + 1) * (order + 1);
+
+      /* two numbers next to each other, as in a solver state vector */
+      std::vector<double> state(2 * size);
+      const NPNumberView x(state.data(), params, order);
+      const NPNumberView y(state.data() + size, params, order);
+      x.assign(in);
+      y.assign(two);
+      BOOST_CHECK_EQUAL(in, x.toNPNumber());
+
+      /* padded rows */
+      const unsigned int stride = params + 3;
+      std::vector<double> padded(stride * (order + 1), -1.0);
+      const NPNumberView p(padded.data(), params, order, stride);
+
+      p.product(x, y);
+      BOOST_CHECK_EQUAL(in * two, p.toNPNumber());
+      p.linear(x, 2.0, y, -1.0);
+      BOOST_CHECK_EQUAL(in * 2.0 - two, p.toNPNumber());
+      p.exp(x);
+      BOOST_CHECK_EQUAL(in.exp(), p.toNPNumber());
+      BOOST_CHECK_EQUAL(padded[params + 1], -1.0);
+
+      /* products of views with the same padded stride stay out of the gaps, the last row has none */
+      const unsigned int extent = order * stride + params + 1;
+      std::vector<double> pa(extent, -7.5), pb(extent, -7.5), pt(extent, -7.5);
+      const NPNumberView va(pa.data(), params, order, stride);
+      const NPNumberView vb(pb.data(), params, order, stride);
+      const NPNumberView vt(pt.data(), params, order, stride);
+      va.assign(in);
+      vb.assign(two);
+      vt.product(va, vb);
+      BOOST_CHECK_EQUAL(in * two, vt.toNPNumber());
+      BOOST_CHECK_EQUAL(std::count(pt.begin(), pt.end(), -7.5), order * (stride - params - 1));
+
+      std::vector<double> t(size);
+      const NPNumberView target(t.data(), params, order);
+      target.log(y);
+      BOOST_CHECK_EQUAL(two.log(), target.toNPNumber());
+      target.pow(p, 3);
+      checkClose(in.exp().pow(3), target.toNPNumber());
+      target.compose(expDerivatives(in.der(0, 0), order).data(), in);
+      BOOST_CHECK_EQUAL(compose(in, expDerivatives(in.der(0, 0), order)), target.toNPNumber());
+
+      /* in place */
+      x.product(x, y);
+      BOOST_CHECK_EQUAL(in * two, x.toNPNumber());
+      y.sqrt(y);
+      BOOST_CHECK_EQUAL(two.sqrt(), y.toNPNumber());
+      y.sum(y, 1.0);
+      BOOST_CHECK_EQUAL(two.sqrt() + 1.0, y.toNPNumber());
+
+      /* overlapping one field apart */
+      const NPNumber xs = x.toNPNumber();
+      const NPNumberView shifted(state.data() + 1, params, order);
+      shifted.scaled(x, 2.0);
+      BOOST_CHECK_EQUAL(xs * 2.0, shifted.toNPNumber());
+    }
+
+    void testAlignedNumbers(const NPNumber& in) {
+      const NPNumber two = in * 0.5 + 2.0;
+      const AlignedNPNumber x(in);
+      const AlignedNPNumber y(two);
+      const unsigned int order = in.order();
+
+      BOOST_CHECK_EQUAL(x.stride() % VECTOR_DOUBLES, 0u);
+      BOOST_CHECK_EQUAL(reinterpret_cast<std::uintptr_t>(x.data()) % FIELD_ALIGNMENT, 0u);
+      BOOST_CHECK_EQUAL(in, x.toNPNumber());
+      BOOST_CHECK_EQUAL(in.der(in.params(), order), x.der(in.params(), order));
+
+      /* the padded kernel sums the same terms as the packed one */
+      BOOST_CHECK_EQUAL(in * two, (x * y).toNPNumber());
+      BOOST_CHECK_EQUAL(in * 2.0 - two + 1.0, (x * 2.0 - y + 1.0).toNPNumber());
+
+      AlignedNPNumber t(in.params(), order);
+      t.view().product(x, y);
+      BOOST_CHECK_EQUAL(in * two, t.toNPNumber());
+      t.view().exp(x);
+      BOOST_CHECK_EQUAL(in.exp(), t.toNPNumber());
+
+      /* the padded buffers of the C API */
+      const int params = in.params();
+      std::vector<double> packed(in.data().begin(), in.data().end());
+      std::vector<double> a(tnp_number_padded_payload_size(params, order) / sizeof(double), -1.0);
+      std::vector<double> b(a.size());
+      std::vector<double> c(a.size());
+      op_tnp_number_pad(params, order, a.data(), packed.data());
+      BOOST_CHECK(std::equal(a.begin(), a.end(), x.data()));
+      y.view().copyTo(packed.data());
+      op_tnp_number_pad(params, order, b.data(), packed.data());
+      op_tnp_number_mult_padded(params, order, c.data(), a.data(), b.data());
+      op_tnp_number_unpad(params, order, packed.data(), c.data());
+      BOOST_CHECK_EQUAL(in * two, ConstNPNumberView(packed.data(), params, order).toNPNumber());
+    }
+
+    void testTransposedNumbers(const NPNumber& in) {
+      const NPNumber two = in * 0.5 + 2.0;
+      const TransposedNPNumber x(in);
+      const TransposedNPNumber y(two);
+      const unsigned int params = in.params();
+      const unsigned int order = in.order();
+
+      BOOST_CHECK_EQUAL(in, x.toNPNumber());
+      for (unsigned int j = 0; j <= params; ++j)
+	for (unsigned int n = 0; n <= order; ++n)
+	  BOOST_CHECK_EQUAL(in.der(j, n), x.series(j)[n]);
+
+      /* the transposed kernels sum the same terms as the order-major ones */
+      BOOST_CHECK_EQUAL(in * two, (x * y).toNPNumber());
+      BOOST_CHECK_EQUAL(in * 2.0 - two + 1.0, (x * 2.0 - y + 1.0).toNPNumber());
+      const std::vector<double> f = expDerivatives(in.der(0, 0), order);
+      BOOST_CHECK_EQUAL(compose(in, f), x.compose(f).toNPNumber());
+      const NPNumber square = in * in;
+      BOOST_CHECK_EQUAL(compose(square, expDerivatives(square.der(0, 0), order)), (x * x).exp().toNPNumber());
+
+      /* from a padded view and through the C API */
+      const AlignedNPNumber padded(in);
+      BOOST_CHECK(x == TransposedNPNumber(padded.view()));
+
+      std::vector<double> a(in.data().begin(), in.data().end());
+      std::vector<double> b(two.data().begin(), two.data().end());
+      std::vector<double> ta(a.size()), tb(a.size()), t(a.size());
+      op_tnp_number_to_parameter_major(params, order, ta.data(), a.data());
+      op_tnp_number_to_parameter_major(params, order, tb.data(), b.data());
+      op_tnp_number_mult_parameter_major(params, order, t.data(), ta.data(), tb.data());
+      op_tnp_number_to_order_major(params, order, a.data(), t.data());
+      BOOST_CHECK_EQUAL(in * two, ConstNPNumberView(a.data(), params, order).toNPNumber());
+    }
+
+    /**
+     * a model right hand side, for NPNumber and TapeNumber, y must be positive
+     */
+    template<class N> std::vector<N> tapeModel(const N& x, const N& y) {
+      const N p = x * y + 1.0;
+      const std::pair<N, N> sc = (p * 0.5).sincos();
+      const std::pair<N, N> shc = (x * 0.25).sinhcosh();
+      std::vector<N> out;
+      out.push_back((p - y).pow(3) * 2.0 + x.exp());
+      out.push_back(sc.first.hypot(sc.second) - shc.second * shc.first);
+      out.push_back(y.sqrt() + y.cbrt() * y.log() - y.pow(1.5));
+      out.push_back(y.pow(x * 0.125).atan2(y));
+      return out;
+    }
+
+    void testTapes(const NPNumber& in) {
+      /* tapes compute on full fields, so compare against numbers without the constant shortcuts */
+      const NPNumber x = ConstNPNumberView(in).toNPNumber();
+      const NPNumber y = ConstNPNumberView(in * 0.5 + 2.0).toNPNumber();
+
+      Tape tape(in.params(), in.order());
+      const TapeNumber tx = tape.input();
+      const TapeNumber ty = tape.input();
+      tape.output(tapeModel(tx, ty));
+      BOOST_CHECK_EQUAL(tape.inputs().size(), 2u);
+      BOOST_CHECK_EQUAL(tape.outputs().size(), 4u);
+
+      TapeEvaluator eval(tape);
+      const std::vector<NPNumber> expected = tapeModel(x, y);
+      const std::vector<NPNumber> actual = eval({x, y});
+      for (unsigned int i = 0; i < expected.size(); ++i)
+	BOOST_CHECK_EQUAL(expected[i], actual[i]);
+
+      /* replay on new seeds */
+      const NPNumber x2 = ConstNPNumberView(in * 0.5 - 0.25).toNPNumber();
+      const std::vector<NPNumber> again = tapeModel(x2, y);
+      const std::vector<NPNumber> replayed = eval({x2, y});
+      for (unsigned int i = 0; i < again.size(); ++i)
+	BOOST_CHECK_EQUAL(again[i], replayed[i]);
+
+      NPNumber x3(x2);
+      x3.der(0, 0) = 0.75;
+      eval.seed(0, 0.75);
+      eval.run();
+      BOOST_CHECK_EQUAL(tapeModel(x3, y)[0], eval.output(0).toNPNumber());
+
+      /* inputs of the wrong count or shape give no outputs */
+      BOOST_CHECK(eval({x}).empty());
+      BOOST_CHECK(eval({x, NPNumber(in.params() + 1, in.order())}).empty());
+
+      /* operands and outputs of another tape and unknown functions are NaN */
+      Tape other(in.params(), in.order());
+      const TapeNumber foreign = other.input();
+      tape.output(tx * foreign);
+      tape.output(foreign);
+      tape.output(tx.apply(FunctionRegistry::size() + 12345u));
+      TapeEvaluator mixed(tape);
+      const std::vector<NPNumber> nans = mixed({x, y});
+      BOOST_CHECK(std::isnan(nans[4].der(0, 0)));
+      BOOST_CHECK(std::isnan(nans[5].der(0, 0)));
+      BOOST_CHECK(std::isnan(nans[6].der(0, 0)));
+    }
+
+    /**
+     * a model with a repeated product, a constant subgraph and a dead result
+     */
+    template<class N> std::vector<N> redundantModel(const N& x, const N& y, const N& two) {
+      const N c = two.pow(3) * 0.5 + 1.0;
+      const N unused = (x * y).exp();
+      (void) unused;
+      std::vector<N> out;
+      out.push_back((x * x + y) * c);
+      out.push_back((x * x + 1.0).sqrt() + y.log());
+      return out;
+    }
+
+    void testTapeOptimizer(const NPNumber& in) {
+      const NPNumber x = ConstNPNumberView(in).toNPNumber();
+      const NPNumber y = ConstNPNumberView(in * 0.5 + 2.0).toNPNumber();
+
+      Tape tape(in.params(), in.order());
+      const TapeNumber tx = tape.input();
+      const TapeNumber ty = tape.input();
+      tape.output(redundantModel(tx, ty, tape.constant(2.0)));
+
+      TapeOptimizer::Report report;
+      const Tape optimized = TapeOptimizer::optimize(tape, TapeOptimizer::TAPE_ALL, &report);
+      BOOST_TEST_MESSAGE(report);
+      BOOST_CHECK_EQUAL(report.instructionsBefore, tape.instructions().size());
+      BOOST_CHECK_EQUAL(report.instructionsAfter, optimized.instructions().size());
+      BOOST_CHECK_LT(report.instructionsAfter, report.instructionsBefore);
+      BOOST_CHECK_LT(report.slotsAfter, report.slotsBefore);
+      BOOST_CHECK_EQUAL(report.folded, 3u);
+      BOOST_CHECK_EQUAL(report.simplified, 1u);
+      BOOST_CHECK_EQUAL(report.common, 1u);
+      BOOST_CHECK_GE(report.dead, 2u);
+
+      TapeEvaluator plain(tape);
+      TapeEvaluator fast(optimized);
+      const std::vector<NPNumber> expected = plain({x, y});
+      const std::vector<NPNumber> actual = fast({x, y});
+      for (unsigned int i = 0; i < expected.size(); ++i)
+	checkClose(expected[i], actual[i]);
+
+      /* without folding the rewritten tape computes bit for bit the same */
+      const Tape exact = TapeOptimizer::optimize(tape, TapeOptimizer::TAPE_CSE | TapeOptimizer::TAPE_DCE |
+						 TapeOptimizer::TAPE_SLOTS);
+      TapeEvaluator exactEval(exact);
+      const std::vector<NPNumber> same = exactEval({x, y});
+      for (unsigned int i = 0; i < expected.size(); ++i)
+	BOOST_CHECK_EQUAL(expected[i], same[i]);
+
+      /* registered functions of constants fold to a constant */
+      static const unsigned int exp = FunctionRegistry::add([](double x, unsigned int) { return std::exp(x); });
+      Tape applied(in.params(), in.order());
+      const TapeNumber ax = applied.input();
+      applied.output(ax * applied.constant(0.25).apply(exp));
+      TapeOptimizer::Report applyReport;
+      const Tape foldedApply = TapeOptimizer::optimize(applied, TapeOptimizer::TAPE_ALL, &applyReport);
+      BOOST_CHECK_EQUAL(applyReport.folded, 1u);
+      TapeEvaluator applyEval(foldedApply);
+      checkClose(x * std::exp(0.25), applyEval({x})[0]);
+
+      /* the replay of the model of testTapes survives slot reuse */
+      Tape model(in.params(), in.order());
+      const TapeNumber mx = model.input();
+      const TapeNumber my = model.input();
+      model.output(tapeModel(mx, my));
+      TapeEvaluator reused(TapeOptimizer::allocateSlots(model));
+      const std::vector<NPNumber> direct = tapeModel(x, y);
+      const std::vector<NPNumber> replayed = reused({x, y});
+      for (unsigned int i = 0; i < direct.size(); ++i)
+	BOOST_CHECK_EQUAL(direct[i], replayed[i]);
+    }
+
+    void testParallelTapes(const std::pair<unsigned int, unsigned int> sizes) {
+      const unsigned int params = sizes.first;
+      const unsigned int order = sizes.second;
+      const NPNumber x = ConstNPNumberView(NPNumber::freeVar(params, order, 0.5).asParameter(params - 1)).toNPNumber();
+      const NPNumber y = ConstNPNumberView(x * 0.5 + 2.0).toNPNumber();
+
+      /* many independent equations, registered functions run concurrently */
+      static const unsigned int exp = FunctionRegistry::add([](double x, unsigned int) { return std::exp(x); });
+      Tape tape(params, order);
+      const TapeNumber tx = tape.input();
+      const TapeNumber ty = tape.input();
+      for (unsigned int k = 0; k < 16; ++k) {
+	tape.output(tapeModel(tx * (0.125 * (k + 1)), ty + 0.25 * k));
+	tape.output((tx * (0.125 * k)).apply(exp));
+      }
+
+      TapeEvaluator serial(tape);
+      const std::vector<NPNumber> expected = serial({x, y});
+
+      const Tape reused = TapeOptimizer::allocateSlots(tape);
+      for (unsigned int threads = 1; threads <= 4; ++threads) {
+	for (bool deterministic : {false, true}) {
+	  ParallelTapeEvaluator parallel(threads % 2 ? tape : reused, threads, deterministic);
+	  BOOST_CHECK_EQUAL(parallel.threads(), threads);
+	  BOOST_CHECK_LT(parallel.criticalPath(), parallel.work());
+
+	  for (unsigned int run = 0; run < 3; ++run) {
+	    const std::vector<NPNumber> actual = parallel({x, y});
+	    for (unsigned int i = 0; i < expected.size(); ++i)
+	      BOOST_CHECK_EQUAL(expected[i], actual[i]);
+	  }
+	  BOOST_CHECK(parallel({x}).empty());
+	}
+      }
+    }
+
+    void testCompiledTapes(const std::pair<unsigned int, unsigned int> sizes) {
+      const unsigned int params = sizes.first;
+      const unsigned int order = sizes.second;
+      const NPNumber x = ConstNPNumberView(NPNumber::freeVar(params, order, 0.5).asParameter(params - 1)).toNPNumber();
+      const NPNumber y = ConstNPNumberView(x * 0.5 + 2.0).toNPNumber();
+
+      Tape tape(params, order);
+      const TapeNumber tx = tape.input();
+      const TapeNumber ty = tape.input();
+      tape.output(tapeModel(tx, ty));
+      tape.output((tx * ty + tx * tx) * -0.0 - tape.constant(0.75) * ty);
+
+      TapeEvaluator serial(tape);
+      const std::vector<NPNumber> expected = serial({x, y});
+
+      /* the default cache is the user's, the tests use one of their own */
+      const TapeCompiler defaults;
+      const std::string directory = privateDirectory();
+      const TapeCompiler compiler(defaults.compiler(), defaults.flags(), directory);
+      CompiledTape compiled = compiler.compile(tape);
+      BOOST_CHECK(compiled.compiled());
+      const std::vector<NPNumber> actual = compiled({x, y});
+      for (unsigned int i = 0; i < expected.size(); ++i)
+	BOOST_CHECK_EQUAL(expected[i], actual[i]);
+
+      /* reused from the cache, also for an equal tape */
+      const Tape copy(tape);
+      BOOST_CHECK_EQUAL(TapeCompiler::hash(copy), TapeCompiler::hash(tape));
+      BOOST_CHECK_EQUAL(compiler.load(copy).get(), compiler.load(tape).get());
+      BOOST_CHECK(TapeCompiler::hash(TapeOptimizer::allocateSlots(tape)) != TapeCompiler::hash(tape));
+
+      const Tape reused = TapeOptimizer::optimize(tape);
+      TapeEvaluator optimized(reused);
+      const std::vector<NPNumber> expectedReused = optimized({x, y});
+      const std::vector<NPNumber> actualReused = compiler.compile(reused)({x, y});
+      for (unsigned int i = 0; i < expectedReused.size(); ++i)
+	BOOST_CHECK_EQUAL(expectedReused[i], actualReused[i]);
+
+      /* without a compiler the tape is interpreted */
+      const TapeCompiler missing("/nonexistent/cc", compiler.flags(), compiler.directory());
+      CompiledTape interpreted = missing.compile(tape);
+      BOOST_CHECK(!interpreted.compiled());
+      const std::vector<NPNumber> fallback = interpreted({x, y});
+      for (unsigned int i = 0; i < expected.size(); ++i)
+	BOOST_CHECK_EQUAL(expected[i], fallback[i]);
+      BOOST_CHECK(interpreted({x}).empty());
+
+      /* a cache directory others can access is not used */
+      const std::string shared = privateDirectory();
+      chmod(shared.c_str(), 0755);
+      BOOST_CHECK(!TapeCompiler(compiler.compiler(), compiler.flags() + " -DTNP_SHARED", shared).compile(tape).compiled());
+      BOOST_CHECK(filesIn(shared, "").empty());
+      removeDirectory(shared);
+
+      /* objects that changed since they were built are rebuilt, not loaded */
+      const std::string other = privateDirectory();
+      const TapeCompiler rebuilding(compiler.compiler(), compiler.flags(), other);
+      BOOST_CHECK(rebuilding.compile(TapeOptimizer::allocateSlots(tape)).compiled());
+      for (const std::string& object : filesIn(other, ".so"))
+	truncate(object.c_str(), 0);
+      CompiledTape rebuilt = rebuilding.compile(TapeOptimizer::allocateSlots(tape));
+      BOOST_CHECK(rebuilt.compiled());
+      const std::vector<NPNumber> again = rebuilt({x, y});
+      for (unsigned int i = 0; i < expected.size(); ++i)
+	BOOST_CHECK_EQUAL(expected[i], again[i]);
+      BOOST_CHECK_EQUAL(filesIn(other, ".so").size(), 1u);
+      BOOST_CHECK(filesIn(other, ".log").empty());
+      removeDirectory(other);
+
+      removeDirectory(directory);
+    }
+
+    void testHandlesInto(const std::pair<unsigned int, unsigned int> sizes) {
+      const int params = sizes.first;
+      const int order = sizes.second;
+      tnp_number* x = tnp_number_create_variable(0.5, params + order > 0 ? 1 : 0, params, order);
+      tnp_number* y = tnp_number_exp(x);
+      tnp_number* t = tnp_number_create(params, order);
+      tnp_number* c = tnp_number_create(params, order);
+
+      typedef tnp_number* (*Unary)(tnp_number*);
+      typedef void (*UnaryInto)(tnp_number*, tnp_number*);
+      const std::vector<std::pair<Unary, UnaryInto> > unary({
+	  std::make_pair(&tnp_number_exp, &tnp_number_exp_into),
+	    std::make_pair(&tnp_number_log, &tnp_number_log_into),
+	    std::make_pair(&tnp_number_sqrt, &tnp_number_sqrt_into),
+	    std::make_pair(&tnp_number_cbrt, &tnp_number_cbrt_into)});
+
+      typedef tnp_number* (*Binary)(tnp_number*, tnp_number*);
+      typedef void (*BinaryInto)(tnp_number*, tnp_number*, tnp_number*);
+      const std::vector<std::pair<Binary, BinaryInto> > binary({
+	  std::make_pair(&tnp_number_add, &tnp_number_add_into),
+	    std::make_pair(&tnp_number_sub, &tnp_number_sub_into),
+	    std::make_pair(&tnp_number_mult, &tnp_number_mult_into),
+	    std::make_pair(&tnp_number_npow, &tnp_number_npow_into),
+	    std::make_pair(&tnp_number_atan2, &tnp_number_atan2_into),
+	    std::make_pair(&tnp_number_hypot, &tnp_number_hypot_into)});
+
+      for (const std::pair<Unary, UnaryInto>& f : unary) {
+	tnp_number* expected = f.first(y);
+	f.second(t, y);
+	BOOST_CHECK_EQUAL(fromHandle(expected), fromHandle(t));
+	tnp_number_delete(expected);
+      }
+
+      for (const std::pair<Binary, BinaryInto>& f : binary) {
+	tnp_number* expected = f.first(y, x);
+	f.second(t, y, x);
+	BOOST_CHECK_EQUAL(fromHandle(expected), fromHandle(t));
+	tnp_number_delete(expected);
+      }
+
+      tnp_number* expected = tnp_number_pow(y, 3);
+      tnp_number_pow_into(t, y, 3);
+      BOOST_CHECK_EQUAL(fromHandle(expected), fromHandle(t));
+      tnp_number_delete(expected);
+
+      tnp_number* s = nullptr;
+      tnp_number* co = nullptr;
+      tnp_number_sincos(x, &s, &co);
+      tnp_number_sincos_into(t, c, x);
+      BOOST_CHECK_EQUAL(fromHandle(s), fromHandle(t));
+      BOOST_CHECK_EQUAL(fromHandle(co), fromHandle(c));
+      tnp_number_delete(s);
+      tnp_number_delete(co);
+
+      /* into an operand */
+      const NPNumber before = fromHandle(y);
+      tnp_number_mult_into(y, y, x);
+      BOOST_CHECK_EQUAL(before * fromHandle(x), fromHandle(y));
+      tnp_number_dadd_into(y, y, 2.0);
+      BOOST_CHECK_EQUAL(before * fromHandle(x) + 2.0, fromHandle(y));
+      tnp_number_exp_into(y, y);
+      BOOST_CHECK_EQUAL((before * fromHandle(x) + 2.0).exp(), fromHandle(y));
+
+      tnp_number_assign(t, x);
+      BOOST_CHECK_EQUAL(fromHandle(x), fromHandle(t));
+
+      /* a target of another shape takes the shape of the result */
+      tnp_number* other = tnp_number_create(params + 1, order + 1);
+      tnp_number_mult_into(other, x, x);
+      BOOST_CHECK_EQUAL(fromHandle(x) * fromHandle(x), fromHandle(other));
+      tnp_number* wide = tnp_number_create(params + 1, order + 1);
+      tnp_number_sincos_into(other, wide, x);
+      BOOST_CHECK_EQUAL(fromHandle(x).sincos().second, fromHandle(wide));
+      tnp_number_delete(wide);
+      tnp_number_delete(other);
+
+      tnp_number_delete(c);
+      tnp_number_delete(t);
+      tnp_number_delete(y);
+      tnp_number_delete(x);
+    }
+
+    /**
+     * a chain of buffer operations on the free variable, evaluated in ctx
+     */
+    inline std::vector<double> contextChain(tnp_context* ctx, unsigned int params, unsigned int order) {
+      static const unsigned int exp = FunctionRegistry::add([](double x, unsigned int) { return std::exp(x); });
+
+      const unsigned int size = (params + 1) * (order + 1);
+      std::vector<double> x(size), y(size), z(size);
+      op_tnp_number_write_variable(params, order, x.data(), 0.5, params + order > 0 ? 1 : 0);
+
+      op_tnp_number_exp_ctx(ctx, params, order, y.data(), x.data());
+      op_tnp_number_mult_ctx(ctx, params, order, z.data(), x.data(), y.data());
+      op_tnp_number_pow_ctx(ctx, params, order, y.data(), z.data(), 5);
+      op_tnp_number_atan2_ctx(ctx, params, order, z.data(), y.data(), x.data());
+      op_tnp_number_dadd(params, order, y.data(), z.data(), 1.0);
+      op_tnp_number_apply_ctx(ctx, params, order, z.data(), y.data(), exp);
+      return z;
+    }
+
+    void testContexts(const std::pair<unsigned int, unsigned int> sizes) {
+      const unsigned int params = sizes.first;
+      const unsigned int order = sizes.second;
+      const std::vector<double> expected = contextChain(tnp_context_default(), params, order);
+
+      tnp_context* ctx = tnp_context_create(order);
+      BOOST_CHECK(expected == contextChain(ctx, params, order));
+
+      /* the method of a context does not leak into the default one */
+      tnp_context_pow_method(ctx, POW_COMPOSITION);
+      BOOST_CHECK_EQUAL(Power::method().load(), POW_AUTOMATIC);
+
+      /* methods out of range are ignored */
+      tnp_context_pow_method(ctx, POW_COMPOSITION + 1);
+      BOOST_CHECK_EQUAL(ctx->powerMethod().load(), POW_COMPOSITION);
+
+      /* low powers leave nothing of earlier calls in the scratch memory in their higher derivatives */
+      const unsigned int size = (params + 1) * (order + 1);
+      std::vector<double> arg(size), square(size), reused(size);
+      op_tnp_number_write_variable(params, order, arg.data(), 0.5, params + order > 0 ? 1 : 0);
+      Power::apply(2, arg.data(), square.data(), order, params + 1, POW_COMPOSITION);
+      double* dirty = ctx->scratch(Power::scratchSize(order, params + 1));
+      std::fill(dirty, dirty + Power::scratchSize(order, params + 1), NAN);
+      op_tnp_number_pow_ctx(ctx, params, order, reused.data(), arg.data(), 2);
+      BOOST_CHECK(square == reused);
+      const PowerMethod before = tnp_context_default()->powerMethod();
+      op_pow_method(-1);
+      BOOST_CHECK_EQUAL(tnp_context_default()->powerMethod(), before);
+
+      /* so are negative orders */
+      BOOST_CHECK(tnp_context_create(-1) == NULL);
+      tnp_context_prepare(ctx, -1);
+      BOOST_CHECK(expected == contextChain(ctx, params, order));
+
+      /* one context per thread, the shared tables grow past their first chunk meanwhile */
+      std::vector<std::vector<double> > results(2);
+      std::thread first([&]() { results[0] = contextChain(ctx, params, order); });
+      std::thread second([&]() {
+	  tnp_context* own = tnp_context_create(0);
+	  results[1] = contextChain(own, params, order);
+	  Multiplication::ensureExistance(80 + order);
+	  tnp_context_delete(own);
+	});
+      first.join();
+      second.join();
+      BOOST_CHECK(expected == results[0]);
+      BOOST_CHECK(expected == results[1]);
+
+      /* handles of a context may be deleted through another one */
+      tnp_number* x = tnp_number_create_variable_ctx(ctx, 0.5, params + order > 0 ? 1 : 0, params, order);
+      tnp_number* e = tnp_number_exp_ctx(ctx, x);
+      tnp_number* f = tnp_number_exp(x);
+      BOOST_CHECK_EQUAL(fromHandle(f), fromHandle(e));
+      tnp_number_exp_into_ctx(ctx, f, e);
+      BOOST_CHECK_EQUAL(fromHandle(e).exp(), fromHandle(f));
+      tnp_number_delete(e);
+      tnp_number_delete_ctx(ctx, f);
+      tnp_number_delete_ctx(ctx, x);
+
+      tnp_context_delete(ctx);
+    }
+
+    void testExpressionTemplates(const NPNumber& in) {
+      using expr::lazy;
+      using expr::eval;
+
+      const NPNumber a = in + 1.0;
+      const NPNumber b = in * 3.0;
+      const NPNumber c = in.sincos().first;
+
+      checkClose(a + b - c * 2.0, eval(lazy(a) + b - lazy(c) * 2.0));
+      checkClose(a * b + c * a - b * 2.0, eval(lazy(a) * b + lazy(c) * a - lazy(b) * 2.0));
+      checkClose((a + b) * c, eval((lazy(a) + b) * c));
+      checkClose(a * b * c, eval(lazy(a) * b * c));
+    }
+
+    void testInPlaceArithmetic(const NPNumber& in) {
+      const NPNumber two = in + 2.0;
+
+      BOOST_CHECK_EQUAL(in + two, NPNumber(in) + two);
+      BOOST_CHECK_EQUAL(in + two, in + NPNumber(two));
+      BOOST_CHECK_EQUAL(in - two, NPNumber(in) - two);
+      BOOST_CHECK_EQUAL(in - two, in - NPNumber(two));
+      BOOST_CHECK_EQUAL(in * two, NPNumber(in) * two);
+      BOOST_CHECK_EQUAL(in * two, in * NPNumber(two));
+      BOOST_CHECK_EQUAL(in * 2.0 - 1.0, NPNumber(in) * 2.0 - 1.0);
+
+      NPNumber square(in);
+      square *= square;
+      BOOST_CHECK_EQUAL(in * in, square);
+
+      /* an expiring operand lends its heap buffer to the result */
+      if (!in.isConstant() && in.data().size() > FieldVector::INLINE_FIELDS) {
+	NPNumber tmp(in);
+	const double* buffer = tmp.data().data();
+	const NPNumber res = std::move(tmp) * two + in;
+	BOOST_CHECK_EQUAL(buffer, res.data().data());
+      }
+    }
+
+    void testConstantShortcuts(const NPNumber& in) {
+      const NPNumber c(in.params(), in.order(), 2.5);
+      /* the same constant, but without the tag */
+      const NPNumber full(in.params() + 1, c.data());
+      BOOST_CHECK(c.isConstant());
+      BOOST_CHECK(!full.isConstant());
+      BOOST_CHECK_EQUAL(c, full);
+
+      checkClose(in + full, in + c);
+      checkClose(full - in, c - in);
+      checkClose(in * full, in * c);
+      checkClose(full * in, c * in);
+      checkClose(full.exp(), c.exp());
+      checkClose(full.pow(3), c.pow(3));
+      checkClose(full.pow(0.5), c.pow(0.5));
+
+      BOOST_CHECK((c * c + 1.0).exp().isConstant());
+      BOOST_CHECK_EQUAL(in.isConstant(), (c * in).isConstant());
+
+      /* a constant shared by threads builds its fields once */
+      const NPNumber shared(in.params(), in.order(), 2.5);
+      std::vector<NPNumber> copies(2, c);
+      std::thread first([&]() { copies[0] = NPNumber(shared.params() + 1, shared.data()); });
+      std::thread second([&]() { copies[1] = shared; });
+      first.join();
+      second.join();
+      BOOST_CHECK_EQUAL(full, copies[0]);
+      BOOST_CHECK_EQUAL(full, copies[1]);
+    }
+
+    void testAffineComposition(const NPNumber& in) {
+      /* keep only the value and first derivative rows, i.e. an argument affine in t */
+      const unsigned int width = in.params() + 1;
+      std::vector<double> rows(in.data());
+      std::fill(rows.begin() + std::min<std::size_t>(2 * width, rows.size()), rows.end(), 0.0);
+      const NPNumber affine(width, rows);
+
+      BOOST_CHECK(Composition::degree(affine.data().data(), in.order(), width) <= 1);
+
+      const double x = affine.der(0, 0);
+      const std::vector<std::vector<double>> fs({
+	  cyclicDerivatives(std::sin(x), std::cos(x), -1.0, in.order()), expDerivatives(x, in.order())});
+      const std::vector<NPNumber> recurrences({affine.sincos().first, affine.exp()});
+
+      for (unsigned int i = 0; i < fs.size(); ++i) {
+	const NPNumber viaAffine = compose(affine, fs[i]);
+
+	/* the Bell polynomials, as if the argument had a higher degree */
+	std::vector<double> bell(rows.size());
+	affine.comp()->apply(fs[i].data(), affine.data().data(), bell.data(), width, std::max(in.order(), 2u));
+
+	checkClose(NPNumber(width, bell), viaAffine);
+	checkClose(recurrences[i], viaAffine);
+      }
+    }
+
+    void testComposeMany(const NPNumber& in) {
+      const NPNumber positive = in.exp();
+      const double x = positive.der(0, 0);
+      const std::vector<std::vector<double>> fs({
+	  powDerivatives(x, 2, in.order()), powDerivatives(x, 3, in.order()), 
+	  cyclicDerivatives(std::sin(x), std::cos(x), -1.0, in.order()), logDerivatives(x, in.order())});
+
+      const std::vector<NPNumber> res = positive.compose(fs);
+      BOOST_CHECK_EQUAL(fs.size(), res.size());
+      for (unsigned int i = 0; i < fs.size(); ++i)
+	checkClose(compose(positive, fs[i]), res[i]);
+    }
+
+    void testManyPowersByMethod(const std::pair<unsigned int, unsigned int> sizes) {
+      const NPNumber arg = NPNumber::freeVar(sizes.first, sizes.second, 0.5).exp().asParameter(0);
+      const std::vector<int> exponents({2, 3, 7, -2});
+      const char* names[] = {"automatic", "squaring", "recurrence", "composition"};
+
+      for (int n : exponents) {
+	const PowerMethod chosen = Power::choose(n, arg.data().data(), arg.order(), arg.params() + 1);
+	cout << "Running pow(" << n << ") performance evaluation, order=" << arg.order() 
+	     << ", params=" << arg.params() << ", automatic choice: " << names[chosen] << endl;
+
+	const NPNumber viaComposition = powLoop(arg, n, POW_COMPOSITION, BENCHMARK_ITERATIONS);
+	checkClose(viaComposition, powLoop(arg, n, POW_RECURRENCE, BENCHMARK_ITERATIONS));
+	if (n >= 2)
+	  checkClose(viaComposition, powLoop(arg, n, POW_SQUARING, BENCHMARK_ITERATIONS));
+      }
+    }
+
+    void testManyKernelsByShape(const std::pair<unsigned int, unsigned int> sizes) {
+      const NPNumber a = NPNumber::freeVar(sizes.first, sizes.second, 0.5).exp();
+      NPNumber b = a.sincos().first;
+      for (unsigned int j = 1; j <= sizes.first; ++j)
+	b.der(j, 0) = 0.1 * j;
+      const std::vector<double> f = cyclicDerivatives(std::sin(0.5), std::cos(0.5), -1.0, sizes.second);
+
+      cout << "Running kernel dispatch evaluation, order=" << sizes.second << ", params=" << sizes.first << endl;
+      FixedKernels::enabled() = false;
+      cout << "Generic multiplication: ";
+      const NPNumber genericProduct = productLoop(a, b, DISPATCH_ITERATIONS);
+      cout << "Generic composition: ";
+      const NPNumber genericComposition = compositionLoop(b, f, DISPATCH_ITERATIONS);
+
+      FixedKernels::enabled() = true;
+      cout << "Fixed multiplication: ";
+      const NPNumber fixedProduct = productLoop(a, b, DISPATCH_ITERATIONS);
+      cout << "Fixed composition: ";
+      const NPNumber fixedComposition = compositionLoop(b, f, DISPATCH_ITERATIONS);
+
+      /* the fixed kernels sum the same terms in the same order */
+      BOOST_CHECK_EQUAL(genericProduct, fixedProduct);
+      BOOST_CHECK_EQUAL(genericComposition, fixedComposition);
+    }
+
+    void testManyPooledHandles(const std::pair<unsigned int, unsigned int> sizes) {
+      cout << "Running allocation evaluation, order=" << sizes.second << ", params=" << sizes.first << endl;
+      const Pool::Statistics& stats = Pool::local().statistics();
+
+      /* the pool of a deleted context must not switch off the pool of the thread */
+      tnp_context_delete(tnp_context_create(sizes.second));
+
+      Pool::enabled() = false;
+      std::size_t before = stats.systemAllocations;
+      cout << "System allocator: ";
+      const NPNumber system = handleLoop(sizes.first, sizes.second, DISPATCH_ITERATIONS);
+      const std::size_t systemCount = stats.systemAllocations - before;
+
+      Pool::enabled() = true;
+      cout << "Warm-up: ";
+      handleLoop(sizes.first, sizes.second, 1);
+      before = stats.systemAllocations;
+      cout << "Pool: ";
+      const NPNumber pooled = handleLoop(sizes.first, sizes.second, DISPATCH_ITERATIONS);
+      const std::size_t pooledCount = stats.systemAllocations - before;
+
+      cout << "System allocations: " << systemCount << " without pool, " << pooledCount << " with pool" << endl;
+      BOOST_CHECK_EQUAL(system, pooled);
+      BOOST_CHECK(systemCount > 0);
+      /* once warm, the pool serves every handle and every heap field vector */
+      BOOST_CHECK_EQUAL(pooledCount, 0);
+    }
+
+    void testManyExpsAgainstComposition(const std::pair<unsigned int, unsigned int> sizes) {
+      const NPNumber arg = NPNumber::freeVar(sizes.first, sizes.second, 0.5);
+      cout << "Running exp() performance evaluation, order=" << sizes.second << ", params=" << sizes.first << endl;
+      expCompositionLoop(arg, BENCHMARK_ITERATIONS);
+      const NPNumber result = expLoop(arg, BENCHMARK_ITERATIONS);
+
+      /* d^n/dt^n exp(t) = exp(t) */
+      NPNumber expected(sizes.first, sizes.second);
+      for (unsigned int o = 0; o <= sizes.second; ++o)
+	expected.der(0, o) = std::exp(0.5);
+      checkClose(expected, result);
+    }
   
   }
 }